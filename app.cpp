@@ -6,18 +6,9 @@ int main()
 {
 
     string path = "tmp.html";
-    string content;
-    ifstream file(path);
     try
     {
 
-        if (file)
-        {
-            stringstream buffer;
-            buffer << file.rdbuf();
-            content = buffer.str();
-        }
-
         /*
          title,subtitle,heroTitle,heroDescription,email,github,linkedin
         */
@@ -35,16 +26,18 @@ int main()
             {"email", "contact@example.com"}
 
         };
-        auto elements = parse_html_string(content);
+        auto elements = parse_html_file(path);
         // write answer to x.html
 
         ofstream output("x.html");
         if (output)
         {
+            ostream_sink sink(output);
             for (auto &el : elements)
             {
                 el->set_params_recursive(params);
-                output << el->to_string() << endl;
+                el->write_to(sink);
+                output << endl;
             }
         }
 
@@ -0,0 +1,119 @@
+/**
+ * @file parse_scaling_bench.cpp
+ * @brief Parse time of parse_html() with 1..N threads on a generated document.
+ *
+ * Generates a page shaped like a typical large document (a body holding a
+ * long table and a list of article blocks) and parses it with
+ * parse_options::threads from 1 up to the thread count given, with and
+ * without an arena. Each parse is rendered and checked against the
+ * single-threaded one before it is timed. Prints the best of several runs
+ * and the speedup over one thread.
+ *
+ * Build with -DHTML_BUILD_BENCH=ON -DCMAKE_BUILD_TYPE=Release and run
+ * ./parse_scaling_bench [MiB] [max threads] from the build directory.
+ * The defaults are 8 MiB and std::thread::hardware_concurrency() (at
+ * least 4); speedups above 1 need as many free cores as threads.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "../html-builder.hpp"
+
+using namespace hh_html_builder;
+
+/**
+ * @brief Build a document of about the given size.
+ */
+static std::string generate_document(std::size_t bytes)
+{
+    std::string html = "<!DOCTYPE html>\n<html><head><title>Report</title>"
+                       "<style>td { padding: 2px; }</style></head>\n<body><div class=\"main\">\n";
+    std::size_t row = 0;
+    while (html.size() < bytes)
+    {
+        html += "<table class=\"data\">\n";
+        for (int i = 0; i < 50; i++, row++)
+        {
+            std::string n = std::to_string(row);
+            html += "<tr id=\"r" + n + "\"><td class=\"id\">" + n + "</td><td><a href=\"/item/" + n +
+                    "\">Item " + n + "</a></td><td>&amp; more &lt;text&gt;</td><td><input type=\"checkbox\" checked></td></tr>\n";
+        }
+        html += "</table>\n<article><h2>Section " + std::to_string(row) + "</h2><p>Some <b>bold</b> and "
+                "<i>italic</i> text<br>with a break.</p><!-- note --><pre>  keep\n  this</pre></article>\n";
+    }
+    html += "</div></body></html>\n";
+    return html;
+}
+
+/**
+ * @brief Parse and render once, to check a thread count against the serial result.
+ */
+static std::string render_parse(const std::string &html, std::size_t threads, bool arena)
+{
+    parse_options options;
+    options.threads = threads;
+    if (arena)
+        options.arena = node_arena::create();
+    std::string out;
+    for (const auto &node : parse_html(html, options))
+        out += node->to_string();
+    return out;
+}
+
+/**
+ * @brief Best wall time in milliseconds of several parses.
+ */
+static double best_parse_ms(const std::string &html, std::size_t threads, bool arena, int rounds)
+{
+    double best = 1e300;
+    for (int i = 0; i < rounds; i++)
+    {
+        parse_options options;
+        options.threads = threads;
+        if (arena)
+            options.arena = node_arena::create();
+        auto start = std::chrono::steady_clock::now();
+        auto nodes = parse_html(html, options);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+        if (nodes.empty())
+            std::exit(EXIT_FAILURE);
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t mebibytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+    std::size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10)
+                                       : std::max<std::size_t>(std::thread::hardware_concurrency(), 4);
+    const int rounds = 5;
+
+    std::string html = generate_document(mebibytes << 20);
+    std::printf("document: %zu bytes, hardware threads: %u\n", html.size(), std::thread::hardware_concurrency());
+    std::printf("%-8s %-7s %10s %8s\n", "threads", "arena", "best ms", "speedup");
+
+    for (bool arena : {false, true})
+    {
+        std::string expected = render_parse(html, 1, arena);
+        double serial = 0;
+        for (std::size_t threads = 1; threads <= max_threads; threads++)
+        {
+            if (threads > 1 && render_parse(html, threads, arena) != expected)
+            {
+                std::fprintf(stderr, "%zu threads: output differs from the serial parse\n", threads);
+                return EXIT_FAILURE;
+            }
+            double ms = best_parse_ms(html, threads, arena, rounds);
+            if (threads == 1)
+                serial = ms;
+            std::printf("%-8zu %-7s %10.2f %8.2f\n", threads, arena ? "yes" : "no", ms, serial / ms);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file parallel_parse_check.cpp
+ * @brief Parallel parses against the serial parse, on several document shapes.
+ *
+ * Each generated document is larger than 2 * parallel_parse_min_bytes, so
+ * it is split between threads. It is parsed with 2, 3, 4 and 8 threads,
+ * on the heap and in an arena, with and without zero_copy and
+ * collapse_whitespace, and must render exactly as the single-threaded
+ * parse with the same options. try_parse_html() must return the same
+ * nodes and report no error for these well-formed documents, and the same
+ * diagnostics as a serial parse for a document with a stray closing tag.
+ *
+ * Build with -DHTML_BUILD_CHECKS=ON and run ./parallel_parse_check (or ctest).
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../html-builder.hpp"
+
+using namespace hh_html_builder;
+
+static const std::size_t document_bytes = 2 * parallel_parse_min_bytes + (64 << 10);
+
+/**
+ * @brief Tables and articles in a wrapper div, as in parse_scaling_bench.
+ */
+static std::string generate_report()
+{
+    std::string html = "<!DOCTYPE html>\n<html><head><title>Report</title></head>\n<body><div class=\"main\">\n";
+    for (std::size_t row = 0; html.size() < document_bytes; row++)
+    {
+        std::string n = std::to_string(row);
+        html += "<table><tr id=\"r" + n + "\"><td>" + n + "</td><td><a href=\"/item/" + n + "\">Item " + n +
+                "</a></td><td>&amp; more &lt;text&gt;</td><td><input type=\"checkbox\" checked></td></tr></table>\n"
+                "<article><h2>Section</h2><p>Some <b>bold</b> and <i>italic</i>   text<br>with a break.</p><!-- note --></article>\n";
+    }
+    return html + "</div></body></html>\n";
+}
+
+/**
+ * @brief Many top-level paragraphs with no enclosing element.
+ */
+static std::string generate_flat()
+{
+    std::string html;
+    for (std::size_t i = 0; html.size() < document_bytes; i++)
+        html += "<p class=\"x\">para " + std::to_string(i) + "\n  with\twhitespace   </p>\n";
+    return html;
+}
+
+/**
+ * @brief Preformatted and raw-text blocks whose whitespace must survive collapsing.
+ */
+static std::string generate_preformatted()
+{
+    std::string html = "<html><body>\n";
+    for (std::size_t i = 0; html.size() < document_bytes; i++)
+    {
+        std::string n = std::to_string(i);
+        html += "<pre>  line " + n + "\n    <b>indented</b>  </pre>\n<textarea>  " + n +
+                " <i>raw</i>\n</textarea>\n<script>if (a < b) s = '<div>';</script>\n<div>  a   b  </div>\n";
+    }
+    return html + "</body></html>\n";
+}
+
+/**
+ * @brief The large list sits several levels down, inside a single pre.
+ */
+static std::string generate_nested()
+{
+    std::string html = "<html><body><main><section><pre>\n";
+    for (std::size_t i = 0; html.size() < document_bytes; i++)
+        html += "<span>  item " + std::to_string(i) + "  </span>\n";
+    return html + "</pre></section></main></body></html>\n";
+}
+
+static std::string render(const std::vector<std::shared_ptr<element>> &nodes)
+{
+    std::string out;
+    for (const auto &node : nodes)
+        out += node->to_string();
+    return out;
+}
+
+static parse_options make_options(std::size_t threads, bool arena, bool zero_copy, bool collapse)
+{
+    parse_options options;
+    options.threads = threads;
+    if (arena)
+        options.arena = node_arena::create();
+    options.zero_copy = zero_copy;
+    options.collapse_whitespace = collapse;
+    return options;
+}
+
+/**
+ * @brief Compare every thread count and option combination with the serial parse.
+ * @return Number of comparisons made
+ */
+static std::size_t check_document(const char *name, const std::string &html)
+{
+    std::size_t checked = 0;
+    for (int flags = 0; flags < 8; flags++)
+    {
+        bool arena = flags & 1, zero_copy = flags & 2, collapse = flags & 4;
+        std::string expected = render(parse_html(html, make_options(1, arena, zero_copy, collapse)));
+        for (std::size_t threads : {2, 3, 4, 8})
+        {
+            parse_options options = make_options(threads, arena, zero_copy, collapse);
+            if (render(parse_html(html, options)) != expected)
+            {
+                std::fprintf(stderr, "%s: %zu threads (arena %d, zero_copy %d, collapse %d) differ from the serial parse\n",
+                             name, threads, arena, zero_copy, collapse);
+                std::exit(EXIT_FAILURE);
+            }
+            checked++;
+            if (zero_copy || collapse)
+                continue;
+            parse_result result = try_parse_html(html, make_options(threads, arena, false, false));
+            if (!result || render(result.nodes) != expected)
+            {
+                std::fprintf(stderr, "%s: try_parse_html() with %zu threads differs from the serial parse\n", name, threads);
+                std::exit(EXIT_FAILURE);
+            }
+            checked++;
+        }
+    }
+    return checked;
+}
+
+/**
+ * @brief A large document with an error must be diagnosed as a serial parse would.
+ */
+static void check_malformed(const std::string &html)
+{
+    std::string broken = html;
+    broken.insert(broken.size() / 2, "</q>");
+    parse_result serial = try_parse_html(broken);
+    if (serial.error != parse_error::unmatched_close_tag)
+    {
+        std::fprintf(stderr, "malformed: serial parse reported %s\n", describe(serial.error));
+        std::exit(EXIT_FAILURE);
+    }
+    for (std::size_t threads : {2, 4, 8})
+    {
+        parse_result result = try_parse_html(broken, make_options(threads, true, false, false));
+        if (result.error != serial.error || result.offset != serial.offset || result.line != serial.line ||
+            result.column != serial.column || result.error_count != serial.error_count ||
+            render(result.nodes) != render(serial.nodes))
+        {
+            std::fprintf(stderr, "malformed: %zu threads differ from the serial parse\n", threads);
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+int main()
+{
+    std::string report = generate_report();
+    std::size_t checked = 0;
+    checked += check_document("report", report);
+    checked += check_document("flat", generate_flat());
+    checked += check_document("preformatted", generate_preformatted());
+    checked += check_document("nested", generate_nested());
+    check_malformed(report);
+    std::printf("%zu parallel parses of 4 documents match the serial parse\n", checked);
+    return EXIT_SUCCESS;
+}
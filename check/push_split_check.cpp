@@ -0,0 +1,122 @@
+/**
+ * @file push_split_check.cpp
+ * @brief push_parser against a whole-buffer parse, for every way to split the input.
+ *
+ * Each document is fed to a push_parser in three chunks, at every pair of
+ * cut points (cuts inside tags, comments, raw-text bodies and closing
+ * tags included), and the rendered nodes must equal those of
+ * parse_html() on the whole document. A generated page is also streamed
+ * with emit_depth 2, which must hand over the children of `<head>` and
+ * `<body>` before finish(), equal to those of a whole-buffer parse.
+ *
+ * Build with -DHTML_BUILD_CHECKS=ON and run ./push_split_check (or ctest).
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../html-builder.hpp"
+
+using namespace hh_html_builder;
+
+static std::string render(const std::vector<std::shared_ptr<element>> &nodes)
+{
+    std::string out;
+    for (const auto &node : nodes)
+        out += node->to_string();
+    return out;
+}
+
+/**
+ * @brief Feed a document at every pair of cut points.
+ * @return Number of splits checked
+ */
+static std::size_t check_splits(const std::string &html)
+{
+    std::string expected = render(parse_html(html));
+    std::string_view input = html;
+    std::size_t checked = 0;
+    for (std::size_t i = 0; i <= input.size(); i++)
+    {
+        for (std::size_t j = i; j <= input.size(); j++)
+        {
+            push_parser parser;
+            parser.feed(input.substr(0, i));
+            parser.feed(input.substr(i, j - i));
+            parser.feed(input.substr(j));
+            if (render(parser.finish()) != expected)
+            {
+                std::fprintf(stderr, "split at %zu and %zu differs: %s\n", i, j, html.c_str());
+                std::exit(EXIT_FAILURE);
+            }
+            checked++;
+        }
+    }
+    return checked;
+}
+
+/**
+ * @brief Stream a page with emit_depth 2 and compare the streamed nodes.
+ */
+static void check_streaming()
+{
+    std::string page = "<!DOCTYPE html>\n<html><head><title>Rows</title><meta charset=\"utf-8\"></head>\n<body>\n";
+    for (int i = 0; i < 2000; i++)
+        page += "<div class=\"row\" id=\"r" + std::to_string(i) + "\"><b>" + std::to_string(i) + "</b> text<br></div>\n";
+    page += "<script>if (a < b) x = '</div>';</script>\n</body></html>\n";
+
+    std::vector<std::string> expected;
+    for (const auto &node : parse_html(page))
+    {
+        if (node->get_tag() != "html")
+            continue;
+        for (const auto &section : node->get_children())
+            for (const auto &child : section->get_children())
+                expected.push_back(child->to_string());
+    }
+
+    std::vector<std::string> streamed;
+    bool finishing = false;
+    std::string last_tag;
+    push_parser parser(nullptr, [&](std::shared_ptr<element> node)
+                       {
+                           if (!finishing && node->get_tag() != "!DOCTYPE" && node->get_tag() != "html")
+                               streamed.push_back(node->to_string());
+                           last_tag = node->get_tag(); },
+                       2);
+    std::string_view input = page;
+    for (std::size_t i = 0; i < input.size(); i += 61)
+        parser.feed(input.substr(i, 61));
+    finishing = true;
+    parser.finish();
+
+    if (streamed != expected || last_tag != "html")
+    {
+        std::fprintf(stderr, "emit_depth 2: %zu nodes streamed before finish(), %zu expected\n", streamed.size(), expected.size());
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+int main()
+{
+    const std::vector<std::string> documents = {
+        "<!DOCTYPE html><p class=\"a\">Hi <b>there</b></p>",
+        "<div a='1' b=2 c>x<!-- c > d -->y</div><br/><img src=\"i.png\">",
+        "<ul>\n<li>one</li>\n<li>two &amp; three</li>\n</ul>",
+        "<p>a</p><script>if (a < b) x = '</scrip';</script><p>b</p>",
+        "<style>p { color: red }</STYLE ><title>T &lt;</title>",
+        "<textarea>\n  <b>raw</b>\n</textarea>",
+        "<a href=\"x\"\ntitle=\"y\">link</a> tail",
+        "text only, no tags at all",
+    };
+
+    std::size_t checked = 0;
+    for (const auto &html : documents)
+        checked += check_splits(html);
+    check_streaming();
+    std::printf("%zu splits of %zu documents and one streamed page match the whole-buffer parse\n", checked, documents.size());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file recovery_check.cpp
+ * @brief try_parse_html() on malformed input, in every recovery_mode.
+ *
+ * Each case gives an input, a recovery_mode, the rendered nodes expected
+ * and the diagnostics expected for the first error. Well-formed cases must
+ * also render exactly as parse_html() does.
+ *
+ * Build with -DHTML_BUILD_CHECKS=ON and run ./recovery_check (or ctest).
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../html-builder.hpp"
+
+using namespace hh_html_builder;
+
+/**
+ * @brief One input, the mode to parse it in and what try_parse_html() must return.
+ */
+struct recovery_case
+{
+    const char *html;
+    recovery_mode mode;
+    const char *expected;
+    parse_error error;
+    std::size_t offset;
+    std::size_t line;
+    std::size_t column;
+    std::size_t error_count;
+};
+
+static const char *mode_name(recovery_mode mode)
+{
+    switch (mode)
+    {
+    case recovery_mode::auto_close:
+        return "auto_close";
+    case recovery_mode::skip:
+        return "skip";
+    default:
+        return "truncate";
+    }
+}
+
+static std::string render(const std::vector<std::shared_ptr<element>> &nodes)
+{
+    std::string out;
+    for (const auto &node : nodes)
+        out += node->to_string();
+    return out;
+}
+
+int main()
+{
+    const auto auto_close = recovery_mode::auto_close;
+    const auto skip = recovery_mode::skip;
+    const auto truncate = recovery_mode::truncate;
+    const auto none = parse_error::none;
+    const auto unterminated_tag = parse_error::unterminated_tag;
+    const auto unterminated_comment = parse_error::unterminated_comment;
+    const auto unmatched = parse_error::unmatched_close_tag;
+
+    const std::vector<recovery_case> cases = {
+        // Well-formed, including a '<' inside a quoted attribute value
+        {"<p><a title=\"x < y\">t</a></p>", auto_close, "<p><a title=\"x < y\">t</a>\n</p>\n", none, 0, 0, 0, 0},
+        {"<p><a title=\"x < y\">t</a></p>", truncate, "<p><a title=\"x < y\">t</a>\n</p>\n", none, 0, 0, 0, 0},
+        // An unclosed raw-text element runs to the end of the input
+        {"<script>a</scr", auto_close, "<script>a</scr</script>\n", none, 0, 0, 0, 0},
+
+        // A tag cut short by the next '<' is dropped; parsing goes on there except with truncate
+        {"<b x=\"1\" <i>c</i>", auto_close, "<i>c</i>\n", unterminated_tag, 0, 1, 1, 1},
+        {"<b x=\"1\" <i>c</i>", skip, "<i>c</i>\n", unterminated_tag, 0, 1, 1, 1},
+        {"<b x=\"1\" <i>c</i>", truncate, "", unterminated_tag, 0, 1, 1, 1},
+        {"<<b>x</b>", auto_close, "<b>x</b>\n", unterminated_tag, 0, 1, 1, 1},
+        {"<<b>x</b>", truncate, "", unterminated_tag, 0, 1, 1, 1},
+
+        // An unterminated tag or comment ends the parse in every mode
+        {"<div>ok</div><b", auto_close, "<div>ok</div>\n", unterminated_tag, 13, 1, 14, 1},
+        {"<div>ok</div><b", truncate, "<div>ok</div>\n", unterminated_tag, 13, 1, 14, 1},
+        {"<p>a<!-- never closed", auto_close, "<p>a</p>\n", unterminated_comment, 4, 1, 5, 1},
+        {"<p>a<!-- never closed", skip, "<p>a</p>\n", unterminated_comment, 4, 1, 5, 1},
+
+        // Unmatched closing tags
+        {"<p>a</q><b <i>c</i></p>", auto_close, "<p>a<i>c</i>\n</p>\n", unmatched, 4, 1, 5, 2},
+        {"<p>a</q><b <i>c</i></p>", skip, "<p>a<i>c</i>\n</p>\n", unmatched, 4, 1, 5, 2},
+        {"<p>a</q><b <i>c</i></p>", truncate, "<p>a</p>\n", unmatched, 4, 1, 5, 1},
+        {"</div><p>x</p>", auto_close, "<p>x</p>\n", unmatched, 0, 1, 1, 1},
+        {"</div><p>x</p>", truncate, "", unmatched, 0, 1, 1, 1},
+        {"<div><p>a</div>b</p>", auto_close, "<div><p>a</p>\n</div>\nb", unmatched, 9, 1, 10, 2},
+        {"<div><p>a</div>b</p>", skip, "<div><p>ab</p>\n</div>\n", unmatched, 9, 1, 10, 1},
+        {"<div><p>a</div>b</p>", truncate, "<div><p>a</p>\n</div>\n", unmatched, 9, 1, 10, 1},
+        {"<ul><li>a</ul></li>", auto_close, "<ul><li>a</li>\n</ul>\n", unmatched, 9, 1, 10, 2},
+        {"<ul><li>a</ul></li>", skip, "<ul><li>a</li>\n</ul>\n", unmatched, 9, 1, 10, 1},
+        {"<div><b>bold</div>", auto_close, "<div><b>bold</b>\n</div>\n", unmatched, 12, 1, 13, 1},
+        {"<div><b>bold</div>", skip, "<div><b>bold</b>\n</div>\n", unmatched, 12, 1, 13, 1},
+        {"<p>\n  x</span>\n</p>", auto_close, "<p>  x</p>\n", unmatched, 7, 2, 4, 1},
+    };
+
+    int failed = 0;
+    for (const auto &c : cases)
+    {
+        parse_options options;
+        options.recovery = c.mode;
+        parse_result result = try_parse_html(c.html, options);
+        std::string out = render(result.nodes);
+        if (out != c.expected || result.error != c.error || result.offset != c.offset || result.line != c.line ||
+            result.column != c.column || result.error_count != c.error_count)
+        {
+            std::fprintf(stderr, "%s (%s): got \"%s\", %s at %zu (%zu:%zu), %zu errors\n", c.html, mode_name(c.mode), out.c_str(),
+                         describe(result.error), result.offset, result.line, result.column, result.error_count);
+            failed++;
+        }
+        else if (c.error == parse_error::none && render(parse_html(c.html)) != out)
+        {
+            std::fprintf(stderr, "%s: try_parse_html() and parse_html() differ\n", c.html);
+            failed++;
+        }
+    }
+    if (failed)
+        return EXIT_FAILURE;
+    std::printf("%zu recovery cases match\n", cases.size());
+    return EXIT_SUCCESS;
+}
@@ -1,7 +1,22 @@
 #pragma once
 
+#include "includes/atom_table.hpp"
+#include "includes/attribute_list.hpp"
+#include "includes/compiled_template.hpp"
 #include "includes/doctype_element.hpp"
 #include "includes/document_parser.hpp"
 #include "includes/document.hpp"
 #include "includes/element.hpp"
+#include "includes/html_escape.hpp"
+#include "includes/html_handler.hpp"
+#include "includes/html_tokenizer.hpp"
+#include "includes/lazy_element.hpp"
+#include "includes/mapped_file.hpp"
+#include "includes/node_arena.hpp"
+#include "includes/output_sink.hpp"
+#include "includes/param_table.hpp"
+#include "includes/parse_result.hpp"
 #include "includes/self_closing_element.hpp"
+#include "includes/structural_scanner.hpp"
+#include "includes/template_cache.hpp"
+#include "includes/text_ref.hpp"
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <shared_mutex>
+#include <unordered_map>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Process-wide table of interned names (tag names, attribute names).
+     *
+     * Every distinct name is stored once and identified by a small integer.
+     * All standard HTML tag names and common attribute names are pre-seeded
+     * when the table is created, so parsing ordinary markup never has to add
+     * entries; other names are added on first use while there is room.
+     *
+     * Reading the name of an id is lock-free. Interning takes a shared lock
+     * for names that already exist and an exclusive lock only when a new name
+     * is added, so the table can be used from many parsing threads at once.
+     *
+     * @note Entries are never removed, so the table holds at most max_atoms
+     *       names. Once it is full, intern() returns npos and atom stores
+     *       the name itself; inputs with an unbounded number of distinct
+     *       names therefore cost a bounded amount of table memory and never
+     *       make a parse fail.
+     */
+    class atom_table
+    {
+    public:
+        /// Upper bound on the number of interned names (pre-seeded ones included)
+        static constexpr std::size_t max_atoms = std::size_t(1) << 16;
+
+    private:
+        static constexpr std::size_t chunk_bits = 12;
+        static constexpr std::size_t chunk_size = std::size_t(1) << chunk_bits;
+        static constexpr std::size_t chunk_count = max_atoms / chunk_size;
+
+        struct chunk
+        {
+            std::string names[chunk_size];
+        };
+
+        /// Name storage; chunks never move, so views into them stay valid
+        std::atomic<chunk *> chunks[chunk_count] = {};
+
+        /// Index of the pre-seeded names, immutable after construction
+        std::unordered_map<std::string_view, std::uint32_t> seeded;
+
+        /// Index of names added at run time, protected by mutex
+        std::unordered_map<std::string_view, std::uint32_t> added;
+
+        std::atomic<std::uint32_t> count{0};
+        mutable std::shared_mutex mutex;
+
+        atom_table();
+        std::uint32_t append(std::string_view name);
+
+    public:
+        /// Id returned by find() for names that were never interned
+        static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+        atom_table(const atom_table &) = delete;
+        atom_table &operator=(const atom_table &) = delete;
+        ~atom_table();
+
+        /**
+         * @brief Get the process-wide table.
+         * @return Reference to the shared atom table (never destroyed, so
+         *         atoms stay valid during static destruction)
+         */
+        static atom_table &global();
+
+        /**
+         * @brief Get the id of a name, adding it if necessary.
+         * @param name Name to intern (case-sensitive)
+         * @return Id of the name, or npos if it is new and the table is full
+         */
+        std::uint32_t intern(std::string_view name);
+
+        /**
+         * @brief Get the id of a name without adding it.
+         * @param name Name to look up (case-sensitive)
+         * @return Id of the name, or npos if it was never interned
+         */
+        std::uint32_t find(std::string_view name) const;
+
+        /**
+         * @brief Get the name of an id.
+         * @param id Id previously returned by intern() or find()
+         * @return View of the interned name (valid for the program's lifetime)
+         */
+        std::string_view name(std::uint32_t id) const
+        {
+            const chunk *c = chunks[id >> chunk_bits].load(std::memory_order_acquire);
+            return c->names[id & (chunk_size - 1)];
+        }
+
+        /**
+         * @brief Get the number of interned names.
+         * @return Number of distinct names in the table
+         */
+        std::size_t size() const
+        {
+            return count.load(std::memory_order_acquire);
+        }
+    };
+
+    /**
+     * @brief Tag or attribute name, interned in the global atom_table when possible.
+     *
+     * Used for element tag names and attribute names. An atom is 8 bytes:
+     * the id of an interned name, or, once the table is full, a pointer to
+     * a reference-counted copy of the name shared by the copies of the
+     * atom. Comparing two interned atoms is a single integer comparison;
+     * other comparisons fall back to comparing the names. The
+     * default-constructed atom is the empty name (id 0).
+     *
+     * An atom converts implicitly to std::string_view, so it can be written
+     * to sinks and compared with strings directly.
+     */
+    class atom
+    {
+        /// Name stored by an atom that could not be interned, followed by its characters
+        struct owned_name
+        {
+            std::atomic<std::size_t> references;
+            std::size_t size;
+
+            const char *data() const { return reinterpret_cast<const char *>(this + 1); }
+        };
+
+        /// `(id << 1) | 1` for an interned name, otherwise an owned_name pointer
+        std::uintptr_t bits = 1;
+
+        bool interned() const { return (bits & 1) != 0; }
+        owned_name *owned() const { return reinterpret_cast<owned_name *>(bits); }
+
+        static std::uintptr_t make_owned(std::string_view name);
+
+        void retain() const
+        {
+            if (!interned())
+                owned()->references.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release();
+
+    public:
+        atom() = default;
+
+        /**
+         * @brief Intern a name, or keep a copy of it if the table is full.
+         * @param name Name to intern (case-sensitive)
+         */
+        explicit atom(std::string_view name)
+        {
+            std::uint32_t id = atom_table::global().intern(name);
+            bits = id != atom_table::npos ? (std::uintptr_t(id) << 1) | 1 : make_owned(name);
+        }
+
+        atom(const atom &other) noexcept : bits(other.bits)
+        {
+            retain();
+        }
+
+        atom(atom &&other) noexcept : bits(other.bits)
+        {
+            other.bits = 1;
+        }
+
+        atom &operator=(const atom &other) noexcept
+        {
+            other.retain();
+            release();
+            bits = other.bits;
+            return *this;
+        }
+
+        atom &operator=(atom &&other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                bits = other.bits;
+                other.bits = 1;
+            }
+            return *this;
+        }
+
+        ~atom()
+        {
+            release();
+        }
+
+        /**
+         * @brief Look up an already interned name without adding it.
+         * @param name Name to look up
+         * @param out Receives the atom when found
+         * @return true if the name is interned
+         *
+         * @note Names that arrived after the table filled up are never
+         *       interned; to test whether an atom has a given name, compare
+         *       it with the string instead.
+         */
+        static bool try_find(std::string_view name, atom &out)
+        {
+            std::uint32_t id = atom_table::global().find(name);
+            if (id == atom_table::npos)
+                return false;
+            out = atom();
+            out.bits = (std::uintptr_t(id) << 1) | 1;
+            return true;
+        }
+
+        /// Numeric id of the atom, dense and small for pre-seeded names (npos if not interned)
+        std::uint32_t id() const { return interned() ? static_cast<std::uint32_t>(bits >> 1) : atom_table::npos; }
+
+        /// Name of the atom
+        std::string_view view() const
+        {
+            if (interned())
+                return atom_table::global().name(static_cast<std::uint32_t>(bits >> 1));
+            return std::string_view(owned()->data(), owned()->size);
+        }
+
+        /// Copy of the name as a std::string
+        std::string str() const { return std::string(view()); }
+
+        /// Whether this is the empty name
+        bool empty() const { return bits == 1; }
+
+        operator std::string_view() const { return view(); }
+
+        bool operator==(const atom &other) const
+        {
+            if (bits == other.bits)
+                return true;
+            // Two different ids are two different names
+            if (interned() && other.interned())
+                return false;
+            return view() == other.view();
+        }
+        bool operator!=(const atom &other) const { return !(*this == other); }
+
+        friend bool operator==(const atom &a, std::string_view name) { return a.view() == name; }
+        friend bool operator==(std::string_view name, const atom &a) { return a.view() == name; }
+        friend bool operator!=(const atom &a, std::string_view name) { return a.view() != name; }
+        friend bool operator!=(std::string_view name, const atom &a) { return a.view() != name; }
+        friend bool operator==(const atom &a, const char *name) { return a.view() == name; }
+        friend bool operator!=(const atom &a, const char *name) { return a.view() != name; }
+
+        friend std::ostream &operator<<(std::ostream &out, const atom &a) { return out << a.view(); }
+    };
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <utility>
+#include <initializer_list>
+
+#include "small_vector.hpp"
+#include "atom_table.hpp"
+#include "text_ref.hpp"
+
+namespace hh_html_builder
+{
+    /// A single HTML attribute: interned name in `first`, value in `second`
+    using attribute = std::pair<atom, text_ref>;
+
+    /**
+     * @brief Flat, insertion-ordered store for the attributes of an element.
+     *
+     * Attributes are kept in a small_vector whose first entry lives inline
+     * in the element, so an element with at most one attribute needs no
+     * allocation beyond the strings themselves, and serialization walks a
+     * single contiguous array instead of chasing tree nodes. One slot keeps
+     * elements small: most nodes of a page (text nodes included) carry no
+     * attributes, and parsed elements usually keep theirs as text (see
+     * element::set_attribute_text()).
+     *
+     * Names are stored as atoms, so lookups are linear scans comparing 4-byte
+     * ids, which beat hashing or tree search for the handful of attributes a
+     * real element carries. Attributes keep the order
+     * in which they were first set, so parsed elements render their
+     * attributes in source order; setting an existing name replaces its value
+     * in place. Bulk builders such as the parser append() without that
+     * check and call remove_duplicates() once, which hashes the names of
+     * long lists instead of comparing every pair.
+     *
+     * The interface mirrors the parts of std::map that element code relies
+     * on (`find`, `operator[]`, iteration over `first`/`second` pairs), and
+     * the list converts implicitly from and to
+     * `std::map<std::string, std::string>` for existing callers.
+     */
+    class attribute_list
+    {
+    public:
+        /// Number of attributes stored without a heap allocation
+        static constexpr std::size_t inline_capacity = 1;
+
+        using iterator = attribute *;
+        using const_iterator = const attribute *;
+
+    private:
+        small_vector<attribute, inline_capacity> items;
+
+    public:
+        attribute_list() = default;
+
+        /**
+         * @brief Build from a list of name/value pairs.
+         * @param attributes Attributes in the order they should render
+         *
+         * Example: attribute_list{{"class", "container"}, {"id", "main"}}
+         */
+        attribute_list(std::initializer_list<std::pair<std::string_view, std::string_view>> attributes);
+
+        /**
+         * @brief Build from a map (attributes end up in the map's key order).
+         * @param attributes Map of attribute names to values
+         */
+        attribute_list(const std::map<std::string, std::string> &attributes);
+
+        iterator begin() { return items.begin(); }
+        iterator end() { return items.end(); }
+        const_iterator begin() const { return items.begin(); }
+        const_iterator end() const { return items.end(); }
+
+        std::size_t size() const { return items.size(); }
+        bool empty() const { return items.empty(); }
+
+        /**
+         * @brief Find an attribute by name.
+         * @param name Attribute name
+         * @return Iterator to the attribute, or end() if absent
+         */
+        iterator find(std::string_view name);
+        const_iterator find(std::string_view name) const;
+        iterator find(atom name);
+        const_iterator find(atom name) const;
+
+        /**
+         * @brief Get the value of an attribute, if present.
+         * @param name Attribute name
+         * @return Pointer to the value, or nullptr if absent
+         */
+        const text_ref *get(std::string_view name) const;
+
+        /**
+         * @brief Set an attribute, replacing the value of an existing one.
+         * @param name Attribute name
+         * @param value Attribute value
+         */
+        void set(std::string_view name, std::string_view value);
+        void set(atom name, std::string_view value);
+
+        /**
+         * @brief Set an attribute, keeping a borrowed value borrowed.
+         * @param name Interned attribute name
+         * @param value Attribute value (moved in)
+         */
+        void set(atom name, text_ref &&value);
+
+        /**
+         * @brief Add an attribute at the end without looking for an existing one.
+         * @param name Interned attribute name
+         * @param value Attribute value (moved in)
+         *
+         * Call remove_duplicates() once the batch is complete if the name
+         * may already be present.
+         */
+        void append(atom name, text_ref &&value);
+
+        /**
+         * @brief Merge attributes that share a name.
+         *
+         * Each name keeps the position of its first occurrence and the value
+         * of its last, the same result as set() called once per attribute.
+         * Short lists compare every pair; longer ones go through a hash of
+         * the names, so the cost stays linear in the number of attributes.
+         */
+        void remove_duplicates();
+
+        /**
+         * @brief Access the value of an attribute, adding it empty if absent.
+         * @param name Attribute name
+         * @return Reference to the stored value (a borrowed value is copied
+         *         into owned storage first)
+         */
+        std::string &operator[](std::string_view name);
+
+        /**
+         * @brief Remove an attribute.
+         * @param name Attribute name
+         * @return Number of attributes removed (0 or 1)
+         */
+        std::size_t erase(std::string_view name);
+
+        /**
+         * @brief Remove every attribute.
+         */
+        void clear();
+
+        /**
+         * @brief Convert to a map keyed by attribute name.
+         * @return Copy of the attributes as a std::map
+         */
+        operator std::map<std::string, std::string>() const;
+
+        /**
+         * @brief Check whether attribute text is written exactly as it renders.
+         * @param text Attribute text of an opening tag, after the tag name
+         * @return true for bare names and `name="value"` pairs (with a
+         *         non-empty value) separated by single spaces, no name repeated
+         *
+         * Parsing such text and rendering the attributes gives back the same
+         * bytes, so a parsed element can keep the text as written and copy it
+         * to the output instead of building a list (see
+         * element::set_attribute_text()). Markup written any other way, such
+         * as `a='x'`, `a=x` or `a=""`, renders differently and returns false.
+         */
+        static bool is_canonical_text(std::string_view text);
+
+        /**
+         * @brief Read the next attribute of canonical attribute text.
+         * @param text Text for which is_canonical_text() holds
+         * @param pos Offset to read at (0 for the first attribute); advanced
+         *            past the attribute
+         * @param name Receives the attribute name
+         * @param value Receives the value (empty for a bare name)
+         * @return false once the text is exhausted
+         */
+        static bool next_canonical(std::string_view text, std::size_t &pos, std::string_view &name, std::string_view &value);
+
+        /**
+         * @brief Build a list from canonical attribute text.
+         * @param text Text for which is_canonical_text() holds
+         * @param borrow Store values as slices of text instead of copies
+         * @return Attributes in source order
+         */
+        static attribute_list from_canonical_text(std::string_view text, bool borrow);
+
+        bool operator==(const attribute_list &other) const;
+        bool operator!=(const attribute_list &other) const
+        {
+            return !(*this == other);
+        }
+    };
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <map>
+#include <cstddef>
+
+#include "element.hpp"
+#include "document.hpp"
+#include "output_sink.hpp"
+#include "param_table.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Pre-serialized form of an element tree for fast repeated rendering.
+     *
+     * A compiled_template is built once from an element tree (typically the
+     * result of parse_html_string()) and can then be rendered any number of
+     * times with different parameter maps. During compilation the tree is
+     * serialized a single time and split into a flat list of static byte runs
+     * interleaved with `{{name}}` parameter slots.
+     *
+     * Rendering is then reduced to copying the static runs and looking up one
+     * value per slot; no element is copied, no tree is walked and no string is
+     * rescanned. This replaces the per-request `copy()` +
+     * `set_params_recursive()` + `to_string()` sequence.
+     *
+     * Example usage:
+     * ```cpp
+     * auto elements = parse_html_string(html);
+     * compiled_template page(elements);          // once, at startup
+     *
+     * std::string out = page.render({{"title", "Dashboard"}});  // per request
+     * ```
+     *
+     * @note The template is immutable after construction, so a single instance
+     *       can be rendered concurrently from many threads.
+     * @note Placeholders whose name is missing from the parameter map are
+     *       written back unchanged, matching parse_html_with_params().
+     * @note Substituted values are not rescanned, so a value that itself
+     *       contains `{{...}}` is emitted literally.
+     * @note Each slot remembers whether it sits in text content or inside an
+     *       attribute value, so rendering with an escaping param_table
+     *       escapes every value for the right context.
+     */
+    class compiled_template
+    {
+        /// One static run followed by an optional parameter slot
+        struct segment
+        {
+            /// Offset of the static run inside static_bytes
+            std::size_t offset;
+
+            /// Length of the static run in bytes
+            std::size_t length;
+
+            /// Index into slot_names, or npos when the segment has no slot
+            std::size_t slot;
+        };
+
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        /// All static runs stored back to back
+        std::string static_bytes;
+
+        /// Segments in output order
+        std::vector<segment> segments;
+
+        /// Parameter name of each slot, in output order (names may repeat)
+        std::vector<std::string> slot_names;
+
+        /// Output context of each slot, used when rendering with escaping
+        std::vector<escape_context> slot_contexts;
+
+        void compile(const std::string &serialized);
+
+    public:
+        /**
+         * @brief Compile a single element tree.
+         * @param root Root element of the tree to compile
+         */
+        explicit compiled_template(const element &root);
+
+        /**
+         * @brief Compile a sequence of top-level elements.
+         * @param elements Elements to compile, rendered in order
+         *
+         * Accepts the vector returned by parse_html_string() directly.
+         */
+        explicit compiled_template(const std::vector<std::shared_ptr<element>> &elements);
+
+        /**
+         * @brief Compile a complete document including its DOCTYPE.
+         * @param doc Document to compile
+         */
+        explicit compiled_template(const document &doc);
+
+        /**
+         * @brief Render the template into an output sink.
+         * @param params Map of parameter names to replacement values
+         * @param sink Destination that receives the rendered bytes
+         * @param escape_values HTML-escape each value for the context of its slot
+         */
+        void render(const std::map<std::string, std::string> &params, output_sink &sink, bool escape_values = false) const;
+
+        /**
+         * @brief Render the template with parameters from a prebuilt index.
+         * @param params Parameter index, reusable across many renders
+         * @param sink Destination that receives the rendered bytes
+         */
+        void render(const param_table &params, output_sink &sink) const;
+
+        /**
+         * @brief Render the template into a new string.
+         * @param params Map of parameter names to replacement values
+         * @param escape_values HTML-escape each value for the context of its slot
+         * @return Rendered HTML, allocated once at its exact final size
+         */
+        std::string render(const std::map<std::string, std::string> &params, bool escape_values = false) const;
+
+        /**
+         * @brief Compute the exact byte length of a render with the given parameters.
+         * @param params Map of parameter names to replacement values
+         * @param escape_values Count values escaped for the context of their slot
+         * @return Number of bytes render() would produce
+         */
+        std::size_t rendered_size(const std::map<std::string, std::string> &params, bool escape_values = false) const;
+
+        /**
+         * @brief Compute the exact byte length of a render with a prebuilt index.
+         * @param params Parameter index used to resolve slot names
+         * @return Number of bytes render() would produce
+         */
+        std::size_t rendered_size(const param_table &params) const;
+
+        /**
+         * @brief Get the parameter name of every slot in output order.
+         * @return Slot names; a parameter used several times appears several times
+         */
+        const std::vector<std::string> &get_slot_names() const;
+    };
+}
@@ -25,7 +25,7 @@ namespace hh_html_builder
      * - Custom DOCTYPE declarations for specialized document types
      *
      * @note DOCTYPE elements should typically be the first element in an HTML document
-     * @note This class overrides the to_string() method to produce DOCTYPE-specific output
+     * @note This class overrides the write_open() method to produce DOCTYPE-specific output
      * @note DOCTYPE elements don't support child elements or standard HTML attributes
      */
     class doctype_element : public element
@@ -41,7 +41,7 @@ namespace hh_html_builder
          *
          * The constructor internally uses the base element constructor with
          * "!DOCTYPE" as the tag name and the provided doctype as text content,
-         * but the actual rendering is handled by the overridden to_string() method.
+         * but the actual rendering is handled by the overridden write_open() method.
          *
          * Examples:
          * - doctype_element("html") creates `<!DOCTYPE html>`
@@ -50,11 +50,14 @@ namespace hh_html_builder
          */
         doctype_element(const std::string &doctype) : element("!DOCTYPE", doctype) {}
 
+    protected:
         /**
-         * @brief Convert the DOCTYPE element to its string representation.
-         * @return String containing the properly formatted DOCTYPE declaration
+         * @brief Serialize the DOCTYPE declaration into an output sink.
+         * @param sink Destination that receives the rendered bytes
+         * @param params Parameters to substitute into the declaration, or nullptr
+         * @return false: there are no children or closing tag to render
          *
-         * Overrides the base element's to_string() method to produce the correct
+         * Overrides the base element's write_open() method to produce the correct
          * DOCTYPE syntax. Instead of generating standard HTML tags, this method
          * formats the output as `<!DOCTYPE content>` where content is the
          * document type string provided during construction.
@@ -66,9 +69,12 @@ namespace hh_html_builder
          * @note This method ignores any attributes or child elements since
          *       DOCTYPE declarations don't support these features
          */
-        std::string to_string() const override
+        bool write_open(output_sink &sink, const param_table *params) const override
         {
-            return "<!DOCTYPE " + get_text_content() + ">";
+            sink.write("<!DOCTYPE ", 10);
+            write_text(sink, text_content, params);
+            sink.put('>');
+            return false;
         }
     };
 }
\ No newline at end of file
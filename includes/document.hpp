@@ -15,12 +15,58 @@ namespace hh_html_builder
             this->doctype = doctype;
             root = std::make_shared<element>("html");
         }
+        std::size_t rendered_size() const
+        {
+            counting_sink counter;
+            write_to(counter);
+            return counter.size();
+        }
         std::string to_string() const
         {
-            std::string result = "<!DOCTYPE " + doctype + ">\n";
-            result += root->to_string();
+            std::string result;
+            result.reserve(rendered_size());
+            string_sink sink(result);
+            write_to(sink);
+            return result;
+        }
+        void write_to(output_sink &sink) const
+        {
+            sink.write("<!DOCTYPE ", 10);
+            sink.write(doctype);
+            sink.write(">\n", 2);
+            root->write_to(sink);
+        }
+        std::size_t rendered_size(const std::map<std::string, std::string> &params, bool escape_values = false) const
+        {
+            param_table table(params, escape_values);
+            counting_sink counter;
+            render(table, counter);
+            return counter.size();
+        }
+        std::string render(const std::map<std::string, std::string> &params, bool escape_values = false) const
+        {
+            param_table table(params, escape_values);
+            counting_sink counter;
+            render(table, counter);
+
+            std::string result;
+            result.reserve(counter.size());
+            string_sink sink(result);
+            render(table, sink);
             return result;
         }
+        void render(const std::map<std::string, std::string> &params, output_sink &sink, bool escape_values = false) const
+        {
+            param_table table(params, escape_values);
+            render(table, sink);
+        }
+        void render(const param_table &params, output_sink &sink) const
+        {
+            sink.write("<!DOCTYPE ", 10);
+            sink.write(doctype);
+            sink.write(">\n", 2);
+            root->render(params, sink);
+        }
         void add_child(std::shared_ptr<element> elem)
         {
             if (elem)
@@ -3,15 +3,83 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <functional>
+#include <string_view>
 
 #include "element.hpp"
 #include "self_closing_element.hpp"
+#include "node_arena.hpp"
+#include "html_handler.hpp"
+#include "parse_result.hpp"
+#include "lazy_element.hpp"
 
 namespace hh_html_builder
 {
+    /**
+     * @brief Options controlling how parse_html_string() builds the tree.
+     */
+    struct parse_options
+    {
+        /// Arena that all parsed nodes are allocated from, or nullptr for the heap
+        std::shared_ptr<node_arena> arena;
+
+        /**
+         * Store text and attribute values as slices of the input instead of
+         * copying each one. The input is retained by the arena (one is
+         * created if none is given), which every node keeps alive; a slice
+         * is copied into owned storage only when its node is mutated.
+         */
+        bool zero_copy = false;
+
+        /**
+         * Number of threads to parse with. Documents with at least twice
+         * parallel_parse_min_bytes between sibling elements (for example
+         * the children of `<body>`) are split there into pieces of at least
+         * that size, which are parsed concurrently, then stitched into the
+         * same tree a serial parse builds. With an arena, each extra piece
+         * is allocated from its own arena, which the nodes keep alive. 0
+         * uses one thread per hardware thread, which is a serial parse on a
+         * single-core machine. Measure with bench/parse_scaling_bench on the
+         * target machine before raising it: extra threads only help with
+         * free cores.
+         */
+        std::size_t threads = 1;
+
+        /**
+         * Normalize text the way browsers render it: every run of
+         * whitespace (line breaks included) becomes one space, text split
+         * by comments becomes a single node, and whitespace-only text is
+         * dropped. Text inside `<pre>`, `<textarea>`, `<script>` and
+         * `<style>` is kept exactly as written, line breaks included.
+         * Without this option, line breaks are deleted from text and other
+         * whitespace is kept.
+         */
+        bool collapse_whitespace = false;
+
+        /// How try_parse_html() continues after an unmatched closing tag
+        /// (the throwing entry points ignore this and throw)
+        recovery_mode recovery = recovery_mode::auto_close;
+
+        /**
+         * Build only the top-level nodes. A first pass over the document
+         * records where each element's contents and closing tag are, and
+         * elements are returned as lazy_elements whose children are parsed
+         * the first time they are needed, one level at a time. Subtrees the
+         * caller never looks at cost one tokenizer pass and no allocations.
+         * Implies that the input is retained by the arena as with
+         * zero_copy; threads is ignored, and so is this option by
+         * try_parse_html().
+         */
+        bool lazy = false;
+    };
+
+    /// Smallest piece of a document that parse_options::threads gives to one thread
+    constexpr std::size_t parallel_parse_min_bytes = 256 * 1024;
+
     /**
      * @brief Parse HTML string into a collection of element objects.
-     * @param html Reference to HTML string to parse (may be modified during parsing)
+     * @param html HTML string to parse; not modified
+     * @param arena Optional node_arena that all parsed nodes are allocated from
      * @return Vector of shared pointers to parsed element objects
      *
      * Converts a raw HTML string into a structured collection of element objects
@@ -39,17 +107,244 @@ namespace hh_html_builder
      * // Returns vector with one div element containing p, br, and p children
      * ```
      *
-     * @note The input HTML string may be modified during parsing for optimization
+     * @note The input HTML string is not modified; the nodes copy what
+     *       they need from it (see parse_html() for read-only buffers)
      * @note The parser automatically detects and creates appropriate element types
      *       (regular elements vs. self-closing elements)
      * @note Returns empty vector if the HTML string is empty or contains no valid elements
+     * @note With an arena, nodes and their control blocks are bump-allocated
+     *       from shared blocks instead of one heap allocation per node
+     */
+    std::vector<std::shared_ptr<element>> parse_html_string(std::string &html, const std::shared_ptr<node_arena> &arena = nullptr);
+
+    /**
+     * @brief Parse HTML string into element objects with explicit options.
+     * @param html HTML string to parse; with options.zero_copy or
+     *             options.lazy its buffer is moved into the arena (which the
+     *             nodes keep alive) and html is left empty, otherwise it is
+     *             not modified
+     * @param options Arena, zero-copy, lazy and thread settings
+     * @return Vector of shared pointers to parsed element objects
+     *
+     * Example usage:
+     * ```cpp
+     * parse_options options;
+     * options.zero_copy = true;
+     * auto elements = parse_html_string(html, options);
+     * // Text and attribute values point into the buffer owned by the arena
+     * ```
+     */
+    std::vector<std::shared_ptr<element>> parse_html_string(std::string &html, const parse_options &options);
+
+    /**
+     * @brief Parse read-only HTML into element objects.
+     * @param html HTML to parse; never modified
+     * @param options Arena, zero-copy and thread settings
+     * @return Vector of shared pointers to parsed element objects
+     *
+     * Produces the same nodes as parse_html_string() without requiring a
+     * mutable std::string, so buffers that are shared, memory-mapped or
+     * owned by someone else can be parsed in place. Text and attribute
+     * values are copied into the nodes, which do not reference html after
+     * the call returns. With zero_copy, html is copied once into the arena
+     * and the nodes borrow slices of that copy instead.
+     *
+     * The parser keeps no state between calls, so one buffer may be parsed
+     * by several threads at once, provided each parse uses its own arena.
+     *
+     * Example usage:
+     * ```cpp
+     * static const std::string_view page = "<p class=\"note\">Hi</p>";
+     * auto elements = parse_html(page);
+     * ```
+     */
+    std::vector<std::shared_ptr<element>> parse_html(std::string_view html, const parse_options &options = parse_options());
+
+    /**
+     * @brief Parse HTML without throwing, reporting malformed input in the result.
+     * @param html HTML to parse; never modified
+     * @param options Arena, zero-copy, thread, text and recovery settings
+     * @return Parsed nodes plus the first error's code, byte offset, line
+     *         and column, and the number of errors
+     *
+     * Meant for inputs that are often broken, such as crawled pages:
+     * instead of throwing std::runtime_error and discarding the document,
+     * the parser records the error and keeps going as options.recovery
+     * says, so the result holds everything that could be parsed. Errors
+     * cost no exception unwinding.
+     *
+     * - An unmatched closing tag is handled per recovery_mode. A closing tag
+     *   with no element open, which ends parse_html_string() silently, is
+     *   reported too, and ignored unless recovery is truncate.
+     * - An unterminated comment or tag is dropped together with the rest of
+     *   the input, which cannot contain markup.
+     *
+     * Example usage:
+     * ```cpp
+     * parse_result result = try_parse_html(page);
+     * if (!result)
+     *     log(describe(result.error), result.line, result.column);
+     * index(result.nodes);
+     * ```
+     *
+     * @note Well-formed input produces the same nodes as parse_html()
+     */
+    parse_result try_parse_html(std::string_view html, const parse_options &options = parse_options()) noexcept;
+
+    /**
+     * @brief Parse an HTML file into element objects.
+     * @param path Path of the file to parse
+     * @param options Arena and zero-copy settings
+     * @return Vector of shared pointers to parsed element objects
+     *
+     * The file is memory-mapped read-only (small files are read with a
+     * single read() instead, see mapped_file) and tokenized straight from
+     * the mapping, so it is never copied into a string first. Without
+     * zero_copy the mapping is released before returning; with zero_copy
+     * the arena takes ownership of the mapping and nodes borrow their text
+     * and attribute values from the file's pages.
+     *
+     * Example usage:
+     * ```cpp
+     * parse_options options;
+     * options.zero_copy = true;
+     * auto elements = parse_html_file("templates/index.html", options);
+     * ```
+     *
+     * @note Throws std::runtime_error if the file cannot be opened or mapped
+     * @note With zero_copy the file must not be truncated while nodes
+     *       borrowing from it are alive
+     */
+    std::vector<std::shared_ptr<element>> parse_html_file(const std::string &path, const parse_options &options = parse_options());
+
+    /**
+     * @brief Parse HTML into a stream of events without building a tree.
+     * @param html HTML to parse (not modified)
+     * @param handler Receives open, close, text and doctype events
+     * @return Offset of the token during which the handler called stop(),
+     *         or html.size() if the whole input was parsed
+     *
+     * Runs the same tokenizer as parse_html_string() (comments skipped,
+     * names lowercased, line breaks dropped) but allocates no nodes:
+     * attributes are parsed into one reused attribute_list whose values
+     * borrow from the input. parse_html_string() itself is an html_handler
+     * that builds elements from these events.
+     *
+     * Example usage:
+     * ```cpp
+     * struct tag_counter : html_handler
+     * {
+     *     std::size_t count = 0;
+     *     void on_open(std::string_view, const attribute_list &) override { count++; }
+     * };
+     *
+     * tag_counter counter;
+     * parse_html_events(html, counter);
+     * ```
+     *
+     * @note Throws std::runtime_error for an unterminated comment or a tag
+     *       without a closing '>'; pairing of tags is not checked
      */
-    std::vector<std::shared_ptr<element>> parse_html_string(std::string &html);
+    std::size_t parse_html_events(std::string_view html, html_handler &handler);
+
+    struct tree_builder;
+
+    /**
+     * @brief Incremental parser for HTML that arrives in pieces.
+     *
+     * Accepts the document in chunks of any size, split anywhere (inside a
+     * tag, a comment or a word), and produces the same nodes as
+     * parse_html_string() over the concatenated input. Parsing overlaps
+     * with I/O: each chunk is tokenized as it arrives, and only the bytes of
+     * the one token that is not complete yet are kept buffered. The text of
+     * a raw-text element (`<script>`, `<style>`, `<textarea>`, `<title>`)
+     * becomes a single node, so it stays buffered until its closing tag
+     * has been fed.
+     *
+     * Top-level nodes are handed to the callback as soon as their closing
+     * tag has been fed (text and void elements immediately, the DOCTYPE
+     * when seen); without a callback they are collected and returned by
+     * finish(). Real pages sit inside `<html><body>`, whose closing tags
+     * come last, so for bounded memory give an emit_depth as well: nodes
+     * at that depth are handed over as they complete and are not attached
+     * to their parent, which is handed over later without them. With 2,
+     * the children of `<head>` and `<body>` arrive one by one, then
+     * `<html>` with its empty `<head>` and `<body>`.
+     *
+     * Example usage:
+     * ```cpp
+     * push_parser parser(nullptr, [](std::shared_ptr<element> node)
+     *                    { std::cout << node->to_string(); }, 2);
+     * while (read_chunk(socket, buffer))
+     *     parser.feed(buffer);
+     * parser.finish();
+     * ```
+     *
+     * @note feed() throws std::runtime_error for a mismatched closing tag and
+     *       finish() for an unterminated tag or comment, as parse_html_string()
+     *       does; the parser must not be used after an exception.
+     * @note Text and attribute values are always copied, since the input
+     *       buffer is reused between chunks.
+     */
+    class push_parser
+    {
+        std::unique_ptr<tree_builder> builder;
+        attribute_list attributes;
+        std::string pending;
+        std::string raw_text_tag;
+        std::size_t raw_text_searched = 0;
+        bool stopped = false;
+        bool finished = false;
+
+        void drain(bool partial);
+
+    public:
+        /// Receives each complete top-level node
+        using node_callback = std::function<void(std::shared_ptr<element>)>;
+
+        /**
+         * @brief Create a parser.
+         * @param arena Arena to allocate nodes from, or nullptr for the heap
+         * @param on_node Receives complete top-level nodes; if empty, they are
+         *                returned by finish()
+         * @param emit_depth Also hand nodes this many levels below the top
+         *                   level to on_node as they complete, detached from
+         *                   their parent (0 for top-level nodes only; ignored
+         *                   without on_node)
+         */
+        explicit push_parser(const std::shared_ptr<node_arena> &arena = nullptr, node_callback on_node = nullptr, std::size_t emit_depth = 0);
+        ~push_parser();
+
+        push_parser(push_parser &&) noexcept;
+        push_parser &operator=(push_parser &&) noexcept;
+
+        /**
+         * @brief Parse the next piece of the document.
+         * @param chunk Bytes following the previous chunk (not retained)
+         */
+        void feed(std::string_view chunk);
+
+        /**
+         * @brief Signal the end of the document.
+         * @return Collected top-level nodes, DOCTYPE first (empty when a
+         *         callback was given)
+         *
+         * Elements still open are closed implicitly.
+         */
+        std::vector<std::shared_ptr<element>> finish();
+
+        /**
+         * @brief Get the number of bytes waiting for the rest of their token.
+         * @return Size of the internal buffer
+         */
+        std::size_t buffered() const { return pending.size(); }
+    };
 
     /**
      * @brief Parse HTML template string with parameter substitution.
      * @param text HTML template string containing parameter placeholders
      * @param params Map of parameter names to replacement values
+     * @param escape_values HTML-escape substituted values for where they land
      * @return Processed HTML string with parameters substituted
      *
      * Processes an HTML template string by replacing parameter placeholders
@@ -78,19 +373,22 @@ namespace hh_html_builder
      * // Returns: "<h1>Dashboard</h1><p>Welcome, John Doe!</p>"
      * ```
      *
-     * @note Unmatched parameter placeholders may be left unchanged or removed
-     *       depending on implementation
-     * @note Parameter values are inserted as-is, so HTML escaping should be
-     *       handled separately if needed for security
+     * @note Unmatched parameter placeholders are left unchanged
+     * @note Runs in a single scan of the text; substituted values are not
+     *       rescanned, so a value containing `{{...}}` is inserted literally
+     * @note Parameter values are inserted as-is unless escape_values is set;
+     *       then each value is escaped as an attribute value when the
+     *       placeholder sits inside a tag, and as text content otherwise
      * @note This function returns a processed string rather than element objects
      */
-    std::string parse_html_with_params(const std::string &text, const std::map<std::string, std::string> &params);
+    std::string parse_html_with_params(const std::string &text, const std::map<std::string, std::string> &params, bool escape_values = false);
 
     /**
      * @brief Internal optimized parsing function for HTML string segments.
      * @param html HTML string to parse
      * @param start Starting position within the HTML string
      * @param end Ending position within the HTML string
+     * @param arena Optional node_arena that parsed nodes are allocated from
      * @return Pair containing parsed elements vector and final parsing position
      *
      * Internal optimization function designed for efficient parsing of HTML
@@ -119,5 +417,5 @@ namespace hh_html_builder
      * @note The start and end positions should be valid indices within the HTML string
      * @note Performance characteristics may vary based on HTML complexity and segment size
      */
-    std::pair<std::vector<std::shared_ptr<element>>, size_t> parse_html_optimized(const std::string &html, size_t start, size_t end);
+    std::pair<std::vector<std::shared_ptr<element>>, size_t> parse_html_optimized(const std::string &html, size_t start, size_t end, const std::shared_ptr<node_arena> &arena = nullptr);
 }
\ No newline at end of file
@@ -4,6 +4,12 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <atomic>
+
+#include "output_sink.hpp"
+#include "param_table.hpp"
+#include "attribute_list.hpp"
+#include "text_ref.hpp"
 
 namespace hh_html_builder
 {
@@ -37,18 +43,100 @@ namespace hh_html_builder
     class element
     {
     protected:
-        /// HTML tag name (e.g., "div", "p", "span", "h1")
-        std::string tag;
+        /// Interned HTML tag name (e.g., "div", "p", "span", "h1")
+        atom tag;
+
+        /// Text content contained within the element (owned, or borrowed from a zero-copy parse)
+        text_ref text_content;
+
+        /// HTML attributes as insertion-ordered key-value pairs (e.g., {"class", "container"}, {"id", "main"})
+        attribute_list attributes;
 
-        /// Text content contained within the element
-        std::string text_content;
+        /// Attribute text as written in a parsed opening tag, rendered as is
+        /// until the attributes are changed (empty once parsed into attributes)
+        text_ref attribute_text;
 
-        /// HTML attributes as key-value pairs (e.g., {"class", "container"}, {"id", "main"})
-        std::map<std::string, std::string> attributes;
+        /// Set, with release ordering, once attributes holds the split of attribute_text
+        mutable std::atomic<bool> attributes_split{false};
 
         /// Child elements forming the hierarchical structure
         std::vector<std::shared_ptr<element>> children;
 
+        /**
+         * @brief Write a text run to a sink, substituting parameters if given.
+         * @param sink Destination for the rendered bytes
+         * @param text Text content or attribute value to write
+         * @param params Parameters to substitute, or nullptr to write verbatim
+         */
+        static void write_text(output_sink &sink, std::string_view text, const param_table *params);
+
+        /**
+         * @brief Write the attribute list of this element to a sink.
+         * @param sink Destination for the rendered bytes
+         * @param params Parameters to substitute into values, or nullptr
+         *
+         * Emits each attribute as ` name="value"`, or as ` name` for
+         * attributes whose (substituted) value is empty. Shared by all element
+         * types that render an opening tag.
+         */
+        void write_attributes(output_sink &sink, const param_table *params) const;
+
+        /**
+         * @brief Serialize this element and its subtree, shared by write_to() and render().
+         * @param sink Destination that receives the rendered HTML bytes
+         * @param params Parameters to substitute while writing, or nullptr
+         *
+         * Walks the subtree with an explicit stack, calling write_open() and
+         * write_close() on each element, so documents nested deeper than
+         * the call stack render too. When params is set, `{{name}}`
+         * placeholders in text content and attribute values are replaced on
+         * the fly; the elements themselves are never modified.
+         */
+        void serialize(output_sink &sink, const param_table *params) const;
+
+        /**
+         * @brief Write the opening tag and text content.
+         * @param sink Destination that receives the rendered HTML bytes
+         * @param params Parameters to substitute while writing, or nullptr
+         * @return false if the element has no children or closing tag to render
+         *
+         * @note Specialized element types override this method and
+         *       write_close() to change how they are rendered.
+         */
+        virtual bool write_open(output_sink &sink, const param_table *params) const;
+
+        /**
+         * @brief Write the closing tag, after the children.
+         * @param sink Destination that receives the rendered HTML bytes
+         */
+        virtual void write_close(output_sink &sink) const;
+
+        /**
+         * @brief Build children whose construction was deferred.
+         *
+         * Called before anything reads or changes `children`. Ordinary
+         * elements have nothing to build; lazy_element overrides it to parse
+         * its subtree on first use.
+         */
+        virtual void materialize() const {}
+
+        /**
+         * @brief Replace attribute_text with the attribute list it holds, before changing attributes.
+         */
+        void parse_attribute_text();
+
+        /**
+         * @brief Substitute parameters into this element and its descendants in place.
+         * @param params Prebuilt parameter index shared by the whole traversal
+         */
+        void apply_params_recursive(const param_table &params);
+
+        /**
+         * @brief Substitute parameters into this element's text and attributes in place.
+         * @param params Prebuilt parameter index
+         */
+        void apply_params(const param_table &params);
+
     public:
         /**
          * @brief Default constructor creating an empty element.
@@ -87,7 +175,7 @@ namespace hh_html_builder
         /**
          * @brief Construct element with tag name and attributes.
          * @param tag HTML tag name for the element
-         * @param attributes Map of attribute name-value pairs
+         * @param attributes Attribute name-value pairs (a std::map or brace list also works)
          *
          * Creates an element with specified tag and attributes but no text content.
          * This constructor is useful for elements that need styling or behavior
@@ -96,13 +184,13 @@ namespace hh_html_builder
          * Example: element("div", {{"class", "container"}, {"id", "main"}})
          * creates <div class="container" id="main"></div>
          */
-        element(const std::string &tag, const std::map<std::string, std::string> &attributes);
+        element(const std::string &tag, const attribute_list &attributes);
 
         /**
          * @brief Construct element with tag name, text content, and attributes.
          * @param tag HTML tag name for the element
          * @param text_content Text content to be placed inside the element
-         * @param attributes Map of attribute name-value pairs
+         * @param attributes Attribute name-value pairs (a std::map or brace list also works)
          *
          * Creates a fully specified element with tag, content, and attributes.
          * This constructor provides complete element initialization in a single
@@ -112,7 +200,39 @@ namespace hh_html_builder
          * Example: element("a", "Click here", {{"href", "https://example.com"}, {"target", "_blank"}})
          * creates <a href="https://example.com" target="_blank">Click here</a>
          */
-        element(const std::string &tag, const std::string &text_content, const std::map<std::string, std::string> &attributes);
+        element(const std::string &tag, const std::string &text_content, const attribute_list &attributes);
+
+        /**
+         * @brief Construct element from an already interned tag name.
+         * @param tag Interned HTML tag name
+         * @param attributes Attribute list to apply to the element
+         *
+         * Used by the parser, which interns each tag name once while matching
+         * opening and closing tags. The attributes are moved in, so values
+         * borrowed from a zero-copy parse stay borrowed.
+         */
+        element(atom tag, attribute_list attributes);
+
+        /**
+         * @brief Construct element from an interned tag name, text and attributes.
+         * @param tag Interned HTML tag name (empty atom for a text node)
+         * @param text_content Text content, possibly borrowed from a parse buffer
+         * @param attributes Attribute list to apply to the element
+         */
+        element(atom tag, text_ref text_content, attribute_list attributes);
+
+        element(const element &other);
+        element(element &&other);
+        element &operator=(const element &other);
+        element &operator=(element &&other);
+
+        /**
+         * @brief Destroy the element and release its subtree.
+         *
+         * Descendants that are not shared elsewhere are released iteratively,
+         * so destroying a very deep tree does not recurse once per level.
+         */
+        virtual ~element();
 
         /**
          * @brief Add a child element to this element's hierarchy.
@@ -150,6 +270,8 @@ namespace hh_html_builder
         /**
          * @brief Recursively set parameters on this element and all descendants.
          * @param params Map of parameter name-value pairs to apply
+         * @param escape_values HTML-escape each value for the text content or
+         *                      attribute value it is substituted into
          *
          * Applies the specified parameters to this element and recursively
          * propagates them to all child elements in the hierarchy. This method
@@ -165,11 +287,13 @@ namespace hh_html_builder
          * receive the parameter updates, making it powerful for comprehensive
          * element tree modifications.
          */
-        virtual void set_params_recursive(const std::map<std::string, std::string> &params);
+        virtual void set_params_recursive(const std::map<std::string, std::string> &params, bool escape_values = false);
 
         /**
          * @brief Set parameters on this element only (non-recursive).
          * @param params Map of parameter name-value pairs to apply
+         * @param escape_values HTML-escape each value for the text content or
+         *                      attribute value it is substituted into
          *
          * Applies the specified parameters only to this element, without
          * affecting any child elements. This method provides fine-grained
@@ -181,7 +305,7 @@ namespace hh_html_builder
          * text content placeholders, or other element properties based
          * on the provided parameter mappings.
          */
-        virtual void set_params(const std::map<std::string, std::string> &params);
+        virtual void set_params(const std::map<std::string, std::string> &params, bool escape_values = false);
 
         /**
          * @brief Create a deep copy of this element.
@@ -244,9 +368,93 @@ namespace hh_html_builder
          * This is the primary method for converting the programmatic element
          * structure into actual HTML that can be written to files or sent
          * to web browsers.
+         *
+         * @note Implemented on top of write_to() in two passes: the exact
+         *       output length is measured first (see rendered_size()) so the
+         *       result string is allocated once and never grows.
          */
         virtual std::string to_string() const;
 
+        /**
+         * @brief Compute the exact byte length of the rendered HTML.
+         * @return Number of bytes that to_string() / write_to() would produce
+         *
+         * Walks the element hierarchy without producing any output, counting
+         * the bytes of every tag, attribute, text run and closing-tag line
+         * break. Parameters already applied through set_params() are part of
+         * the element and therefore included in the count.
+         *
+         * Typical uses are reserving an output buffer up front or sending a
+         * Content-Length header before the body is rendered.
+         */
+        std::size_t rendered_size() const;
+
+        /**
+         * @brief Stream this element and its hierarchy into an output sink.
+         * @param sink Destination that receives the rendered HTML bytes
+         *
+         * Produces exactly the same bytes as to_string(), but writes them
+         * straight into the sink as the tree is walked. No intermediate
+         * strings are built, so each byte is copied once regardless of how
+         * deeply the element is nested.
+         *
+         * Example:
+         * ```cpp
+         * std::ofstream out("page.html");
+         * ostream_sink sink(out);
+         * root.write_to(sink);
+         * ```
+         */
+        void write_to(output_sink &sink) const;
+
+        /**
+         * @brief Render this element with parameters substituted, without modifying it.
+         * @param params Map of parameter names to replacement values
+         * @param sink Destination that receives the rendered HTML bytes
+         * @param escape_values HTML-escape each value for the text content or
+         *                      attribute value it is substituted into
+         *
+         * Produces the same bytes as calling set_params_recursive(params) on a
+         * copy() of this element and serializing the copy, but substitutes
+         * `{{name}}` placeholders while writing instead. The element tree is
+         * left untouched, so one parsed template can be shared by every
+         * request (including concurrently) without deep copies.
+         *
+         * Example:
+         * ```cpp
+         * auto page = parse_html_string(html)[0];      // parsed once
+         * page->render({{"title", "Dashboard"}}, sink); // per request
+         * ```
+         */
+        void render(const std::map<std::string, std::string> &params, output_sink &sink, bool escape_values = false) const;
+
+        /**
+         * @brief Render this element with parameters from a prebuilt index.
+         * @param params Parameter index, reusable across many renders
+         * @param sink Destination that receives the rendered HTML bytes
+         *
+         * Same as render(params, sink) but skips building the parameter
+         * index, which pays off when one parameter set is used for several
+         * elements or documents.
+         */
+        void render(const param_table &params, output_sink &sink) const;
+
+        /**
+         * @brief Render this element with parameters substituted into a new string.
+         * @param params Map of parameter names to replacement values
+         * @param escape_values HTML-escape substituted values (see render(params, sink, escape_values))
+         * @return Rendered HTML, allocated once at its exact final size
+         */
+        std::string render(const std::map<std::string, std::string> &params, bool escape_values = false) const;
+
+        /**
+         * @brief Compute the exact byte length of render(params).
+         * @param params Map of parameter names to replacement values
+         * @param escape_values Count substituted values escaped
+         * @return Number of bytes render(params, escape_values) would produce
+         */
+        std::size_t rendered_size(const std::map<std::string, std::string> &params, bool escape_values = false) const;
+
         /**
          * @brief Get the HTML tag name of this element.
          * @return String containing the tag name
@@ -257,18 +465,30 @@ namespace hh_html_builder
          */
         std::string get_tag() const;
 
+        /**
+         * @brief Get the interned tag name of this element.
+         * @return Atom of the tag name; compare against another atom to test
+         *         for a tag without any string comparison
+         */
+        atom get_tag_atom() const;
+
         /**
          * @brief Get all attributes of this element.
-         * @return Map containing all attribute name-value pairs
-         *
-         * Returns a copy of the complete attribute map for this element.
-         * The map contains all HTML attributes that will be included in
-         * the element's opening tag when rendered to HTML.
-         *
-         * @note Returns a copy of the attributes map, so modifications
-         *       to the returned map do not affect the element's attributes.
+         * @return Read-only view of all attribute name-value pairs
+         *
+         * Returns the element's attribute list, in the order the attributes
+         * were set (source order for parsed elements). The list contains all
+         * HTML attributes that will be included in the element's opening tag
+         * when rendered to HTML.
+         *
+         * @note No copy is made; the list converts implicitly to a
+         *       std::map when an independent copy is needed.
+         * @note Parsed elements keep their attributes as text (see
+         *       set_attribute_text()), which the first call splits into the
+         *       list under a lock; later calls cost one atomic load. Shared
+         *       trees can be read from several threads.
          */
-        std::map<std::string, std::string> get_attributes() const;
+        const attribute_list &get_attributes() const;
 
         /**
          * @brief Get the value of a specific attribute.
@@ -278,12 +498,26 @@ namespace hh_html_builder
          * Retrieves the value of a specific attribute by name. If the attribute
          * does not exist on this element, returns an empty string. This method
          * provides convenient access to individual attribute values without
-         * needing to work with the entire attributes map.
+         * needing to work with the entire attribute list.
          *
          * Example: For an element with class="container", calling
          * get_attribute("class") returns "container".
          */
         std::string get_attribute(const std::string &key) const;
+
+        /**
+         * @brief Set the attributes from markup, keeping the text as written.
+         * @param text Attribute text for which attribute_list::is_canonical_text()
+         *             holds, such as `class="note" hidden` (moved in; may be borrowed)
+         *
+         * Replaces the current attributes. The text is copied to the output
+         * verbatim when the element is rendered, and is split into an
+         * attribute list only when get_attributes() is first called or
+         * parameters are applied in place; get_attribute() reads it
+         * directly. The parser stores attributes this way, so markup whose
+         * attributes are never looked at is not split at all.
+         */
+        void set_attribute_text(text_ref text);
     };
 
 }
\ No newline at end of file
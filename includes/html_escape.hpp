@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+#include "output_sink.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Where a piece of text ends up in the HTML output.
+     *
+     * The set of characters that must be escaped depends on the context:
+     * - text: element content, escapes `&`, `<` and `>`
+     * - attribute: double-quoted attribute value, additionally escapes `"` and `'`
+     */
+    enum class escape_context
+    {
+        text,
+        attribute
+    };
+
+    /**
+     * @brief Write text to a sink with HTML special characters escaped.
+     * @param sink Destination that receives the escaped bytes
+     * @param text Raw text to escape
+     * @param context Output context deciding which characters are special
+     *
+     * Special characters are replaced by `&amp;`, `&lt;`, `&gt;`, `&quot;`
+     * and `&#39;`. The input is scanned with a vectorized kernel (AVX2 or
+     * SSE2, selected at runtime, with a table-driven scalar fallback on other
+     * targets) that finds the next special character 16 or 32 bytes at a
+     * time, so clean runs are copied to the sink in bulk and the per-byte
+     * slow path is only taken at the characters that actually need escaping.
+     *
+     * Example: `a < b & "c"` in attribute context becomes
+     * `a &lt; b &amp; &quot;c&quot;`.
+     */
+    void write_escaped(output_sink &sink, std::string_view text, escape_context context);
+
+    /**
+     * @brief Compute the length of text after escaping.
+     * @param text Raw text to measure
+     * @param context Output context deciding which characters are special
+     * @return Number of bytes write_escaped() would produce
+     */
+    std::size_t escaped_size(std::string_view text, escape_context context);
+
+    /**
+     * @brief Escape text into a new string.
+     * @param text Raw text to escape
+     * @param context Output context deciding which characters are special
+     * @return Escaped text, allocated once at its exact final size
+     */
+    std::string escape_html(std::string_view text, escape_context context = escape_context::text);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <string_view>
+
+#include "attribute_list.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Receiver of parse events from parse_html_events().
+     *
+     * Override the events of interest; the rest are ignored. Events arrive
+     * in document order and describe the markup as written: every opening
+     * tag produces on_open (or on_open_raw), every closing tag on_close, and
+     * nothing checks that they pair up or synthesizes closes for void
+     * elements or for elements left open at the end of input.
+     *
+     * No nodes are allocated. Tag names, text and attribute values are views
+     * that stay valid only until the handler returns; they point into the
+     * input except where the text had to be normalized (line breaks
+     * dropped from text or turned into spaces inside tags, text on both
+     * sides of a comment merged, names lowercased).
+     *
+     * Example usage:
+     * ```cpp
+     * struct link_counter : html_handler
+     * {
+     *     std::size_t links = 0;
+     *     void on_open(std::string_view tag, const attribute_list &) override
+     *     {
+     *         if (tag == "a")
+     *             links++;
+     *     }
+     * };
+     *
+     * link_counter counter;
+     * parse_html_events(html, counter);
+     * ```
+     */
+    class html_handler
+    {
+        bool stop_requested = false;
+        bool raw_attributes = false;
+
+    protected:
+        /**
+         * @brief Choose how opening tags are reported.
+         * @param value true to receive on_open_raw() with the attribute text
+         *              unparsed instead of on_open()
+         */
+        void set_raw_attributes(bool value) { raw_attributes = value; }
+
+    public:
+        virtual ~html_handler() = default;
+
+        /**
+         * @brief Opening or void tag.
+         * @param tag Lowercase tag name
+         * @param attributes Attributes in source order; values are borrowed
+         */
+        virtual void on_open(std::string_view tag, const attribute_list &attributes)
+        {
+            (void)tag;
+            (void)attributes;
+        }
+
+        /**
+         * @brief Opening or void tag, with its attributes as written.
+         * @param tag Lowercase tag name
+         * @param attribute_text Text between the tag name and '>' (line
+         *                       breaks turned into spaces), not split into
+         *                       attributes
+         *
+         * Called instead of on_open() once set_raw_attributes(true) has been
+         * called, for handlers that forward attributes or rarely look at
+         * them and so can skip parsing them.
+         */
+        virtual void on_open_raw(std::string_view tag, std::string_view attribute_text)
+        {
+            (void)tag;
+            (void)attribute_text;
+        }
+
+        /**
+         * @brief Closing tag.
+         * @param tag Lowercase tag name (empty for `</>`)
+         */
+        virtual void on_close(std::string_view tag) { (void)tag; }
+
+        /**
+         * @brief Run of text between tags, with comments and line breaks removed.
+         * @param text Text as written, including whitespace-only runs; the
+         *             contents of script, style, textarea and title are
+         *             passed verbatim
+         */
+        virtual void on_text(std::string_view text) { (void)text; }
+
+        /**
+         * @brief `<!DOCTYPE ...>` declaration.
+         * @param declaration Text following `<!DOCTYPE`
+         */
+        virtual void on_doctype(std::string_view declaration) { (void)declaration; }
+
+        /**
+         * @brief Stop the parse after the current event.
+         */
+        void stop() { stop_requested = true; }
+
+        /**
+         * @brief Check whether stop() was called.
+         * @return true if the parse is stopping
+         */
+        bool stopped() const { return stop_requested; }
+
+        /**
+         * @brief Clear a previous stop() so the handler can be reused.
+         */
+        void resume() { stop_requested = false; }
+
+        /**
+         * @brief Check whether opening tags go to on_open_raw().
+         * @return true if set_raw_attributes(true) was called
+         */
+        bool wants_raw_attributes() const { return raw_attributes; }
+    };
+}
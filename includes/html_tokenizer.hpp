@@ -0,0 +1,233 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+#include "structural_scanner.hpp"
+#include "parse_result.hpp"
+
+namespace hh_html_builder
+{
+    /// Kind of token produced by html_tokenizer
+    enum class token_type
+    {
+        /// Run of text between tags
+        text,
+        /// Opening (or void) tag with its raw attribute string
+        open_tag,
+        /// Closing tag
+        close_tag,
+        /// `<!DOCTYPE ...>` declaration
+        doctype
+    };
+
+    /**
+     * @brief One token of an HTML document.
+     *
+     * Views stay valid until the next call to html_tokenizer::next(). When
+     * `borrowed` is set, `content` is a slice of the tokenizer input and
+     * lives as long as the input does.
+     */
+    struct html_token
+    {
+        token_type type = token_type::text;
+
+        /// Lowercase tag name (open_tag, close_tag)
+        std::string_view name;
+
+        /// Text run (text), raw attribute string (open_tag) or declaration
+        /// text following `<!doctype` (doctype)
+        std::string_view content;
+
+        /// Offset of the token's first byte in the input
+        std::size_t offset = 0;
+
+        /// Whether content is a slice of the input rather than scratch storage
+        bool borrowed = true;
+    };
+
+    /**
+     * @brief Single-pass HTML tokenizer over an unmodified input buffer.
+     *
+     * Splits the input into text, tag and doctype tokens in one forward
+     * scan. Normalization happens on the fly instead of in separate passes
+     * that rewrite the input:
+     * - comments are skipped, and text on both sides of a comment is merged
+     *   into one text token
+     * - tag names are lowercased
+     * - line breaks are dropped from text (unless keep_line_breaks is set),
+     *   and turned into spaces inside tags, where they separate the tag name
+     *   and attributes like any other whitespace
+     *
+     * The contents of raw-text elements (`<script>`, `<style>`,
+     * `<textarea>` and `<title>`) are not markup: the tokenizer jumps from
+     * the opening tag straight to the matching closing tag and returns
+     * everything in between as one text token, verbatim (line breaks and
+     * anything that looks like a tag or comment are kept).
+     *
+     * Tokens are slices of the input whenever possible; only slices that
+     * need normalization (line breaks, merged text, uppercase names) are
+     * copied into scratch storage owned by the tokenizer.
+     *
+     * Tag boundaries and line breaks are located with a structural_scanner,
+     * which classifies each byte once with SIMD instead of searching the
+     * same text again for '<', '>' and '\n' on every token.
+     *
+     * Example usage:
+     * ```cpp
+     * html_tokenizer tokenizer(html);
+     * html_token token;
+     * while (tokenizer.next(token))
+     * {
+     *     if (token.type == token_type::open_tag)
+     *         std::cout << token.name << "\n";
+     * }
+     * ```
+     *
+     * @note Throws std::runtime_error for an unterminated comment or a tag
+     *       without a closing '>', unless the input is partial or
+     *       set_throw_errors(false) was called.
+     */
+    class html_tokenizer
+    {
+        std::string_view input;
+        std::size_t pos;
+        bool partial;
+        bool keep_line_breaks;
+
+        structural_scanner scanner;
+
+        /// Offset of the closing tag ending the current raw-text element, or npos
+        std::size_t raw_text_end = std::string_view::npos;
+
+        /// Raw-text element whose closing tag is not in the partial input yet, or empty
+        std::string raw_text_tag;
+
+        /// Offset up to which its body has been searched for the closing tag
+        std::size_t raw_text_scan = 0;
+
+        bool throw_errors = true;
+        parse_error failure = parse_error::none;
+        std::size_t failure_offset = 0;
+
+        std::string text_scratch;
+        std::string tag_scratch;
+        std::string name_scratch;
+
+        std::string_view strip_line_breaks(std::string_view text, std::string &scratch, bool &borrowed);
+        std::string_view line_breaks_to_spaces(std::string_view text, bool &borrowed);
+        std::string_view lowercase_name(std::string_view name);
+        void emit_text(html_token &token, std::size_t text_start, std::size_t text_end, bool merged, bool line_break);
+        std::size_t find_raw_text_end(std::string_view tag, std::size_t from);
+        std::size_t raw_text_resume_offset() const;
+        bool fail(parse_error error, std::size_t offset, const char *message);
+
+    public:
+        /**
+         * @brief Create a tokenizer over a buffer.
+         * @param input HTML to tokenize (must outlive the tokenizer)
+         * @param start Offset to start tokenizing at
+         * @param partial The input is a prefix of a document whose remainder
+         *                has not arrived yet
+         * @param keep_line_breaks Leave line breaks in text tokens (for
+         *                         consumers that collapse whitespace themselves)
+         */
+        explicit html_tokenizer(std::string_view input, std::size_t start = 0, bool partial = false, bool keep_line_breaks = false);
+
+        /**
+         * @brief Read the next token.
+         * @param token Receives the token
+         * @return false once the input is exhausted
+         *
+         * On partial input, a token that may continue past the end of the
+         * input (trailing text, or an unterminated tag or comment) is not
+         * returned; next() returns false and position() is left at the
+         * token's first byte so tokenizing can resume there once more input
+         * is available. The opening tag of a raw-text element is returned
+         * right away, but its text waits for the closing tag: next() returns
+         * false with position() at the start of the text, and the search
+         * for the closing tag continues from where it stopped (see
+         * pending_raw_text()), so a long body is scanned only once.
+         */
+        bool next(html_token &token);
+
+        /**
+         * @brief Get the offset of the next unread byte.
+         * @return Current position in the input
+         */
+        std::size_t position() const { return pos; }
+
+        /**
+         * @brief Continue tokenizing at another offset.
+         * @param offset Offset of a token boundary: the '<' of a tag, or the
+         *               first byte after one
+         */
+        void seek(std::size_t offset)
+        {
+            pos = offset < input.size() ? offset : input.size();
+            raw_text_end = std::string_view::npos;
+            raw_text_tag.clear();
+        }
+
+        /**
+         * @brief Get the raw-text element whose text is waiting for its closing tag.
+         * @return Its name, or empty; position() is then the start of its text
+         */
+        std::string_view pending_raw_text() const { return raw_text_tag; }
+
+        /**
+         * @brief Get how far the text of pending_raw_text() has been searched.
+         * @return Offset from which the search for its closing tag continues
+         */
+        std::size_t raw_text_searched() const { return raw_text_scan; }
+
+        /**
+         * @brief Start inside the text of a raw-text element, as a new buffer continues an old one.
+         * @param tag Name returned by pending_raw_text() on the old tokenizer
+         * @param searched Offset in this input up to which the text was already
+         *                 searched for the closing tag
+         */
+        void resume_raw_text(std::string_view tag, std::size_t searched);
+
+        /**
+         * @brief Check whether an element's contents are raw text rather than markup.
+         * @param name Lowercase tag name
+         * @return true for `script`, `style`, `textarea` and `title`
+         */
+        static bool is_raw_text_tag(std::string_view name);
+
+        /**
+         * @brief Choose how malformed input is reported.
+         * @param value false to end the input at an unterminated comment or
+         *              tag and report it through error() instead of throwing
+         *
+         * Without exceptions, a tag that runs into another '<' (outside
+         * quoted attribute values) before its '>' is treated as having lost
+         * its '>': next() drops it, returns false with error() set to
+         * parse_error::unterminated_tag and position() at that '<', and
+         * tokenizing can go on from there after clear_error().
+         */
+        void set_throw_errors(bool value) { throw_errors = value; }
+
+        /**
+         * @brief Get the error that stopped tokenizing when errors are not thrown.
+         * @return Error kind, or parse_error::none
+         *
+         * The input is exhausted after an error unless position() is still
+         * before its end, as after a tag that lost its '>'.
+         */
+        parse_error error() const { return failure; }
+
+        /**
+         * @brief Forget error(), to continue tokenizing after a recoverable one.
+         */
+        void clear_error() { failure = parse_error::none; }
+
+        /**
+         * @brief Get the offset of the construct that caused error().
+         * @return Offset of its '<'
+         */
+        std::size_t error_offset() const { return failure_offset; }
+    };
+}
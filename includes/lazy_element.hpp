@@ -0,0 +1,127 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+#include "element.hpp"
+#include "node_arena.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Element boundaries recorded by the first pass of a lazy parse.
+     *
+     * Shared by every lazy_element of one document. Holds the arena that
+     * retains the source buffer, so the offsets stay valid for as long as
+     * any node can still be expanded.
+     */
+    struct lazy_document
+    {
+        /// Byte range of one element (void and raw-text elements excluded)
+        struct span
+        {
+            /// Offset just past the opening tag
+            std::size_t body_start;
+
+            /// Offset of the closing tag (end of input if the element is never closed)
+            std::size_t body_end;
+
+            /// Offset just past the closing tag
+            std::size_t end;
+
+            /// Index of the first span after this element's subtree
+            std::size_t next;
+
+            /// The element is, or is inside, a `<pre>` (used when collapsing whitespace)
+            bool preformatted;
+        };
+
+        /// Document text, retained by arena
+        std::string_view source;
+
+        /// Arena that nodes are allocated from and that retains source
+        std::shared_ptr<node_arena> arena;
+
+        /// Spans in document order; span 0 is the document itself
+        std::vector<span> spans;
+
+        /// Text is parsed with parse_options::collapse_whitespace
+        bool collapse_whitespace = false;
+
+        /// Held while any element of the document is expanded, since expanding allocates from arena
+        mutable std::mutex expand_mutex;
+    };
+
+    /**
+     * @brief Element whose children are parsed the first time they are needed.
+     *
+     * Produced by a parse with parse_options::lazy. The element knows the
+     * byte range of its contents but builds no child nodes until something
+     * reads or changes them: get_children(), rendering, copying, adding a
+     * child or substituting parameters. At that point one level is parsed:
+     * text and void children are built, and element children are again
+     * lazy_elements, so a subtree nobody looks at is never allocated.
+     *
+     * Example usage:
+     * ```cpp
+     * parse_options options;
+     * options.lazy = true;
+     * auto nodes = parse_html_file("page.html", options);
+     * // Only <html> and its direct children are built here; <body> stays unparsed
+     * for (auto &child : nodes.back()->get_children())
+     *     if (child->get_tag() == "head")
+     *         extract_metadata(child);
+     * ```
+     *
+     * Expansion is serialized by a mutex of the document (it allocates
+     * from the document's arena, which is not thread-safe), and each
+     * element is expanded once, so const accessors can be called on a
+     * shared lazy tree from several threads, as on an eager one. Once an
+     * element is expanded, reading it costs one atomic load.
+     *
+     * @note As with any element, changing a tree while other threads read
+     *       it is not safe.
+     */
+    class lazy_element : public element
+    {
+        std::shared_ptr<const lazy_document> document;
+        std::size_t span_index;
+
+        /// Set, with release ordering, once children holds the expanded contents
+        mutable std::atomic<bool> expanded{false};
+
+    protected:
+        void materialize() const override;
+
+    public:
+        /**
+         * @brief Create an element whose contents are still unparsed.
+         * @param tag Interned tag name
+         * @param attributes Parsed attributes
+         * @param document Spans of the document the element belongs to
+         * @param span_index Index of the element's span in document->spans
+         */
+        lazy_element(atom tag, attribute_list attributes, std::shared_ptr<const lazy_document> document, std::size_t span_index);
+
+        /**
+         * @brief Check whether the children have been built.
+         * @return true once the element has been expanded
+         */
+        bool is_materialized() const { return expanded.load(std::memory_order_acquire); }
+    };
+
+    /**
+     * @brief Parse the direct contents of one span of a lazy document.
+     * @param document Document the span belongs to
+     * @param span_index Span to expand (0 for the top-level nodes)
+     * @return Nodes in the span; element children are lazy_elements
+     *
+     * @note This is an internal function used by lazy_element and the parser
+     */
+    std::vector<std::shared_ptr<element>> expand_lazy_span(const std::shared_ptr<const lazy_document> &document, std::size_t span_index);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <memory>
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Read-only memory mapping of a whole file.
+     *
+     * The file's pages are mapped straight into the address space, so
+     * reading it costs no copy into a user buffer and pages are loaded only
+     * as they are touched. The mapping is released when the object is
+     * destroyed.
+     *
+     * Files smaller than mmap_threshold are read into a heap buffer with a
+     * single read() instead: for a few pages, setting up and tearing down a
+     * mapping costs more than copying them.
+     *
+     * Example usage:
+     * ```cpp
+     * mapped_file file("template.html");
+     * std::cout << file.view().size() << " bytes\n";
+     * ```
+     *
+     * @note Throws std::runtime_error if the file cannot be opened or mapped
+     * @note The file must not be truncated while it is mapped; reading a
+     *       page past the new end raises SIGBUS
+     */
+    class mapped_file
+    {
+        const char *data = nullptr;
+        std::size_t size = 0;
+        std::unique_ptr<char[]> buffer;
+
+        void release() noexcept;
+
+    public:
+        /// Smallest file that is memory-mapped rather than read
+        static constexpr std::size_t mmap_threshold = 256 * 1024;
+
+        /**
+         * @brief Map a file.
+         * @param path Path of the file to map
+         */
+        explicit mapped_file(const std::string &path);
+        ~mapped_file();
+
+        mapped_file(const mapped_file &) = delete;
+        mapped_file &operator=(const mapped_file &) = delete;
+
+        mapped_file(mapped_file &&other) noexcept;
+        mapped_file &operator=(mapped_file &&other) noexcept;
+
+        /**
+         * @brief Get the contents of the file.
+         * @return View of the file contents (empty for an empty file)
+         */
+        std::string_view view() const { return std::string_view(data, size); }
+    };
+}
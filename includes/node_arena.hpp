@@ -0,0 +1,198 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "mapped_file.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Bump allocator that owns the memory of a parsed element tree.
+     *
+     * Parsing normally performs one heap allocation per node
+     * (`std::make_shared<element>`). When an arena is passed to the parser,
+     * every node together with its shared_ptr control block is carved out of
+     * large blocks owned by the arena instead. Individual deallocations are
+     * no-ops; the blocks are returned to the system in one step when the
+     * arena is destroyed.
+     *
+     * Nodes keep their arena alive through their allocator, so the arena may
+     * safely be dropped by the caller while parsed elements are still in use.
+     * Once every node has been released, reset() rewinds the arena so the
+     * same blocks can be reused by the next parse without touching the heap.
+     *
+     * Example usage:
+     * ```cpp
+     * auto arena = node_arena::create();
+     * for (auto &request : requests)
+     * {
+     *     auto elements = parse_html_string(request.body, arena);
+     *     // ... use elements ...
+     *     elements.clear();
+     *     arena->reset();  // keep the blocks for the next request
+     * }
+     * ```
+     *
+     * @note Allocation is not thread-safe: an arena should be used by one
+     *       parse at a time. Nodes may be released from any thread.
+     * @note Strings stored inside nodes still use the regular allocator,
+     *       unless the parse is zero-copy: the arena then retains the source
+     *       buffer and nodes borrow slices of it.
+     */
+    class node_arena : public std::enable_shared_from_this<node_arena>
+    {
+        struct block
+        {
+            std::unique_ptr<char[]> data;
+            std::size_t size;
+        };
+
+        std::vector<block> blocks;
+        std::vector<std::shared_ptr<const void>> sources;
+        std::size_t current = 0;
+        std::size_t offset = 0;
+        std::size_t block_size;
+        std::atomic<std::size_t> live{0};
+
+        explicit node_arena(std::size_t block_size);
+
+    public:
+        /**
+         * @brief Create a new arena.
+         * @param block_size Size of each memory block in bytes
+         * @return Shared handle to the arena
+         */
+        static std::shared_ptr<node_arena> create(std::size_t block_size = 64 * 1024);
+
+        node_arena(const node_arena &) = delete;
+        node_arena &operator=(const node_arena &) = delete;
+
+        /**
+         * @brief Allocate raw storage from the arena.
+         * @param size Number of bytes
+         * @param alignment Required alignment (a power of two)
+         * @return Pointer to uninitialized storage
+         */
+        void *allocate(std::size_t size, std::size_t alignment);
+
+        /**
+         * @brief Record that an allocation is no longer in use.
+         *
+         * Memory is not reclaimed individually; this only maintains the live
+         * allocation count checked by reset().
+         */
+        void deallocate() noexcept;
+
+        /**
+         * @brief Keep a source buffer alive for the lifetime of the arena.
+         * @param source Buffer to take ownership of
+         * @return View of the retained buffer; slices of it stay valid until
+         *         the arena is reset or destroyed
+         */
+        std::string_view retain(std::string source);
+
+        /**
+         * @brief Keep a file mapping alive for the lifetime of the arena.
+         * @param source Mapping to take ownership of
+         * @return View of the mapped file; slices of it stay valid until the
+         *         arena is reset or destroyed
+         */
+        std::string_view retain(mapped_file source);
+
+        /**
+         * @brief Keep another object alive for the lifetime of the arena.
+         * @param owner Object to hold a reference to (e.g. the arena that
+         *              retains a source buffer this arena's nodes borrow from)
+         */
+        void keep_alive(std::shared_ptr<const void> owner);
+
+        /**
+         * @brief Rewind the arena so its blocks can be reused.
+         *
+         * Throws std::runtime_error if any allocation is still alive, since
+         * reusing its memory would corrupt the nodes that still reference it.
+         * Retained source buffers are released.
+         */
+        void reset();
+
+        /**
+         * @brief Get the number of allocations that have not been released.
+         * @return Live allocation count
+         */
+        std::size_t live_allocations() const;
+
+        /**
+         * @brief Get the total memory reserved by the arena.
+         * @return Sum of all block sizes in bytes
+         */
+        std::size_t capacity() const;
+    };
+
+    /**
+     * @brief Standard allocator adapter drawing memory from a node_arena.
+     * @tparam T Value type to allocate
+     *
+     * Used with std::allocate_shared so that a node and its control block
+     * share a single arena allocation. Holds a shared reference to the arena,
+     * which keeps the arena alive for as long as any node allocated from it.
+     */
+    template <typename T>
+    class arena_allocator
+    {
+        template <typename U>
+        friend class arena_allocator;
+
+        std::shared_ptr<node_arena> arena;
+
+    public:
+        using value_type = T;
+
+        explicit arena_allocator(std::shared_ptr<node_arena> arena) : arena(std::move(arena)) {}
+
+        template <typename U>
+        arena_allocator(const arena_allocator<U> &other) : arena(other.arena) {}
+
+        T *allocate(std::size_t n)
+        {
+            return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *, std::size_t) noexcept
+        {
+            arena->deallocate();
+        }
+
+        template <typename U>
+        bool operator==(const arena_allocator<U> &other) const
+        {
+            return arena == other.arena;
+        }
+
+        template <typename U>
+        bool operator!=(const arena_allocator<U> &other) const
+        {
+            return arena != other.arena;
+        }
+    };
+
+    /**
+     * @brief Create a node, from an arena if one is given.
+     * @tparam T Element type to create
+     * @param arena Arena to allocate from, or nullptr for the regular heap
+     * @param args Constructor arguments forwarded to T
+     * @return Shared pointer to the new node
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make_node(const std::shared_ptr<node_arena> &arena, Args &&...args)
+    {
+        if (arena)
+            return std::allocate_shared<T>(arena_allocator<T>(arena), std::forward<Args>(args)...);
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+}
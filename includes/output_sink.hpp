@@ -0,0 +1,187 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <cstddef>
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Abstract byte destination used by the streaming serializers.
+     *
+     * Elements and documents serialize themselves by pushing their bytes into
+     * an output_sink through write_to(), instead of building and returning
+     * nested std::string objects. Every byte of the rendered HTML is written
+     * exactly once, straight into its final destination.
+     *
+     * Concrete sinks decide where the bytes end up:
+     * - string_sink appends to a caller-supplied std::string
+     * - ostream_sink forwards to any std::ostream
+     * - fd_sink writes to a POSIX file descriptor through an internal buffer
+     * - counting_sink discards the bytes and only measures their length
+     *
+     * Custom destinations (sockets, compression streams, ...) can be supported
+     * by deriving from this class and implementing write().
+     */
+    class output_sink
+    {
+    public:
+        virtual ~output_sink() = default;
+
+        /**
+         * @brief Append a run of bytes to the sink.
+         * @param data Pointer to the first byte
+         * @param size Number of bytes to append
+         */
+        virtual void write(const char *data, std::size_t size) = 0;
+
+        /**
+         * @brief Append the contents of a string view to the sink.
+         * @param text Bytes to append
+         */
+        void write(std::string_view text)
+        {
+            write(text.data(), text.size());
+        }
+
+        /**
+         * @brief Append a single character to the sink.
+         * @param c Character to append
+         */
+        void put(char c)
+        {
+            write(&c, 1);
+        }
+    };
+
+    /**
+     * @brief Sink that appends to a caller-supplied std::string.
+     *
+     * The string is not cleared on construction, so a single buffer can be
+     * reused across many renders (call clear() on it between uses to keep its
+     * capacity and avoid reallocations).
+     */
+    class string_sink : public output_sink
+    {
+        std::string &buffer;
+
+    public:
+        /**
+         * @brief Construct a sink appending to the given buffer.
+         * @param buffer String that receives the rendered bytes
+         */
+        explicit string_sink(std::string &buffer) : buffer(buffer) {}
+
+        using output_sink::write;
+
+        void write(const char *data, std::size_t size) override
+        {
+            buffer.append(data, size);
+        }
+    };
+
+    /**
+     * @brief Sink that only counts the bytes written to it.
+     *
+     * Used for the measuring pass of two-pass rendering: walking a tree into
+     * a counting_sink yields the exact length of its serialized form without
+     * producing or storing any output. The result can be used to size a
+     * buffer with a single allocation or to emit a Content-Length header
+     * before rendering begins.
+     */
+    class counting_sink : public output_sink
+    {
+        std::size_t count = 0;
+
+    public:
+        using output_sink::write;
+
+        void write(const char *data, std::size_t size) override
+        {
+            (void)data;
+            count += size;
+        }
+
+        /**
+         * @brief Get the number of bytes written so far.
+         * @return Total byte count
+         */
+        std::size_t size() const
+        {
+            return count;
+        }
+    };
+
+    /**
+     * @brief Sink that forwards bytes to a std::ostream.
+     *
+     * Buffering is left to the stream itself (files, string streams and
+     * std::cout are all buffered already).
+     */
+    class ostream_sink : public output_sink
+    {
+        std::ostream &out;
+
+    public:
+        /**
+         * @brief Construct a sink writing to the given stream.
+         * @param out Stream that receives the rendered bytes
+         */
+        explicit ostream_sink(std::ostream &out) : out(out) {}
+
+        using output_sink::write;
+
+        void write(const char *data, std::size_t size) override
+        {
+            out.write(data, static_cast<std::streamsize>(size));
+        }
+    };
+
+    /**
+     * @brief Buffered sink writing to a POSIX file descriptor.
+     *
+     * Small writes are collected in an internal buffer and handed to the
+     * kernel in large blocks. The buffer is flushed when it fills up, when
+     * flush() is called and when the sink is destroyed. The descriptor is not
+     * owned and is never closed by the sink.
+     *
+     * @note Throws std::runtime_error if the underlying write() fails
+     */
+    class fd_sink : public output_sink
+    {
+        int fd;
+        std::string buffer;
+        std::size_t capacity;
+
+        void write_all(const char *data, std::size_t size);
+
+    public:
+        /**
+         * @brief Construct a sink writing to the given file descriptor.
+         * @param fd Open, writable file descriptor
+         * @param buffer_size Size of the internal write buffer in bytes
+         */
+        explicit fd_sink(int fd, std::size_t buffer_size = 64 * 1024);
+
+        fd_sink(const fd_sink &) = delete;
+        fd_sink &operator=(const fd_sink &) = delete;
+
+        /**
+         * @brief Flush any pending bytes before destruction.
+         *
+         * Errors during this final flush are swallowed since destructors
+         * cannot throw; call flush() explicitly to observe them.
+         */
+        ~fd_sink() override;
+
+        using output_sink::write;
+
+        void write(const char *data, std::size_t size) override;
+
+        /**
+         * @brief Hand all buffered bytes to the file descriptor.
+         */
+        void flush();
+    };
+}
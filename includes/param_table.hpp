@@ -0,0 +1,137 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <cstddef>
+#include <cstdint>
+
+#include "output_sink.hpp"
+#include "html_escape.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Hashed, read-only index over a parameter map for placeholder lookup.
+     *
+     * Template parameters are passed around as `std::map<std::string, std::string>`.
+     * Looking a placeholder name up in such a map costs O(log n) string
+     * comparisons and requires the name as a std::string. A param_table is
+     * built once from the map (a single allocation) and answers lookups by
+     * std::string_view with one hash and, typically, one comparison.
+     *
+     * The table only stores views into the source map, so the map must
+     * outlive the table and must not be modified while the table is in use.
+     *
+     * A table can optionally mark its values as untrusted, in which case
+     * every substitution made through it is HTML-escaped for the context it
+     * lands in (text content or attribute value). Template text itself is
+     * never escaped, only the substituted values.
+     *
+     * Example usage:
+     * ```cpp
+     * std::map<std::string, std::string> params = {{"title", "Dashboard"}};
+     * param_table table(params);
+     * const std::string *value = table.find("title");   // -> "Dashboard"
+     *
+     * param_table safe(params, true);                   // escape values on output
+     * root.render(safe, sink);
+     * ```
+     */
+    class param_table
+    {
+        struct slot
+        {
+            std::uint64_t hash;
+            std::string_view name;
+            const std::string *value;
+        };
+
+        /// Open-addressed slots, size is a power of two (or zero)
+        std::vector<slot> slots;
+
+        /// Number of stored parameters
+        std::size_t count = 0;
+
+        /// Whether substituted values are HTML-escaped
+        bool escape = false;
+
+        static std::uint64_t hash_name(std::string_view name);
+
+    public:
+        /**
+         * @brief Build the index over a parameter map.
+         * @param params Map of parameter names to replacement values
+         * @param escape_values Escape substituted values for their output context
+         */
+        explicit param_table(const std::map<std::string, std::string> &params, bool escape_values = false);
+
+        /**
+         * @brief Look up the value of a parameter.
+         * @param name Parameter name (the text between `{{` and `}}`)
+         * @return Pointer to the value, or nullptr if the parameter is unknown
+         */
+        const std::string *find(std::string_view name) const;
+
+        /**
+         * @brief Check whether the table holds no parameters.
+         * @return true if there is nothing to substitute
+         */
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        /**
+         * @brief Check whether substituted values are HTML-escaped.
+         * @return true if the table was built with escape_values set
+         */
+        bool escapes_values() const
+        {
+            return escape;
+        }
+    };
+
+    /**
+     * @brief Write text to a sink with `{{name}}` placeholders substituted.
+     * @param sink Destination that receives the substituted text
+     * @param text Template text to scan
+     * @param params Parameter index used to resolve placeholder names
+     * @param context Where the text is written, used when params escapes values
+     *
+     * Scans the text exactly once, jumping from one `{` to the next with
+     * memchr and copying the runs in between straight to the sink. Each
+     * placeholder is resolved with a single hashed lookup; unknown
+     * placeholders are written back unchanged. When several `{{` precede the
+     * same `}}` (as in `{{{name}}}`) the innermost one opens the placeholder.
+     *
+     * @note Substituted values are written as-is and are never rescanned, so
+     *       a value that itself contains `{{...}}` is emitted literally.
+     */
+    void write_with_params(output_sink &sink, std::string_view text, const param_table &params,
+                           escape_context context = escape_context::text);
+
+    /**
+     * @brief Compute the length of text after placeholder substitution.
+     * @param text Template text to scan
+     * @param params Parameter index used to resolve placeholder names
+     * @param context Where the text is written, used when params escapes values
+     * @return Number of bytes write_with_params() would produce
+     */
+    std::size_t substituted_size(std::string_view text, const param_table &params,
+                                 escape_context context = escape_context::text);
+
+    /**
+     * @brief Write HTML markup to a sink with `{{name}}` placeholders substituted.
+     * @param sink Destination that receives the substituted markup
+     * @param markup Template markup to scan
+     * @param params Parameter index used to resolve placeholder names
+     *
+     * Same as write_with_params(), except that when params escapes values,
+     * the context of each placeholder is read from the markup around it:
+     * placeholders inside a tag are escaped as attribute values, all others
+     * as text content.
+     */
+    void write_markup_with_params(output_sink &sink, std::string_view markup, const param_table &params);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include "element.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Kind of malformed input reported by try_parse_html().
+     */
+    enum class parse_error
+    {
+        /// The input was well-formed
+        none,
+        /// `<!--` without a closing `-->`
+        unterminated_comment,
+        /// `<` without a closing `>`, or a tag that runs into the next `<`
+        unterminated_tag,
+        /// Closing tag that does not match the innermost open element, or
+        /// that appears when no element is open
+        unmatched_close_tag,
+        /// Memory or threads could not be obtained; no nodes are returned
+        out_of_resources,
+        /// The parser failed for another reason (a bug, not bad input); no
+        /// nodes are returned
+        internal_error
+    };
+
+    /**
+     * @brief How try_parse_html() continues after an unmatched closing tag.
+     *
+     * An unterminated comment or tag runs to the end of the input, so in
+     * every mode the parse ends there and the broken construct is dropped.
+     * A tag cut short by the next `<` is dropped too, and parsing goes on
+     * at that `<` except with truncate.
+     */
+    enum class recovery_mode
+    {
+        /// Close every element up to the one the tag names (as browsers
+        /// do); a tag naming no open element is ignored
+        auto_close,
+        /// Ignore the closing tag and keep the open elements as they are
+        skip,
+        /// Stop at the first error and return what was parsed before it,
+        /// with open elements closed implicitly
+        truncate
+    };
+
+    /**
+     * @brief Parsed nodes together with diagnostics for malformed input.
+     *
+     * Describes the first error found; later errors are only counted.
+     * Offsets are in bytes from the start of the input; lines and columns
+     * count from 1, with columns in bytes.
+     */
+    struct parse_result
+    {
+        /// Top-level nodes, DOCTYPE first
+        std::vector<std::shared_ptr<element>> nodes;
+
+        /// First error, or parse_error::none
+        parse_error error = parse_error::none;
+
+        /// Offset of the token where the first error was found
+        std::size_t offset = 0;
+
+        /// Line of the first error
+        std::size_t line = 0;
+
+        /// Column of the first error
+        std::size_t column = 0;
+
+        /// Number of errors found, including the first
+        std::size_t error_count = 0;
+
+        /**
+         * @brief Check whether the input parsed without errors.
+         * @return true if error is parse_error::none
+         */
+        explicit operator bool() const { return error == parse_error::none; }
+    };
+
+    /**
+     * @brief Describe an error code.
+     * @param error Error to describe
+     * @return Static, human-readable description
+     */
+    const char *describe(parse_error error);
+}
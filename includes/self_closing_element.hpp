@@ -58,7 +58,7 @@ namespace hh_html_builder
         /**
          * @brief Construct a self-closing element with tag name and attributes.
          * @param tag HTML tag name for the self-closing element
-         * @param attributes Map of attribute name-value pairs
+         * @param attributes Attribute name-value pairs (a std::map or brace list also works)
          *
          * Creates a self-closing element with the specified tag name and attributes.
          * This constructor is ideal for self-closing elements that require
@@ -71,7 +71,14 @@ namespace hh_html_builder
          * - self_closing_element("input", {{"type", "text"}, {"name", "username"}})
          *   creates a text input element
          */
-        self_closing_element(const std::string &tag, const std::map<std::string, std::string> &attributes);
+        self_closing_element(const std::string &tag, const attribute_list &attributes);
+
+        /**
+         * @brief Construct a self-closing element from an already interned tag name.
+         * @param tag Interned HTML tag name
+         * @param attributes Attribute list to apply to the element
+         */
+        self_closing_element(atom tag, attribute_list attributes);
 
         /**
          * @brief Override to prevent adding child elements to self-closing elements.
@@ -91,26 +98,31 @@ namespace hh_html_builder
          */
         virtual void add_child(std::shared_ptr<element> child) override;
 
+    protected:
         /**
-         * @brief Convert the self-closing element to its string representation.
-         * @return String containing the properly formatted self-closing element
+         * @brief Serialize the self-closing element into an output sink.
+         * @param sink Destination that receives the rendered HTML bytes
+         * @param params Parameters to substitute into attribute values, or nullptr
+         * @return false: there are no children or closing tag to render
          *
-         * Overrides the base element's to_string() method to produce the correct
+         * Overrides the base element's write_open() method to produce the correct
          * self-closing syntax. The output format follows HTML5 standards for
          * void elements, typically rendering as `<tag attributes>` without a
          * closing tag, or `<tag attributes />` in XHTML-style formatting.
          *
          * The method ensures that self-closing elements are rendered correctly
          * according to HTML specifications, without closing tags that would
-         * be invalid for these element types.
+         * be invalid for these element types. to_string(), write_to() and
+         * render() all reach the element through this method.
          *
          * Examples:
-         * - `<br>` for line breaks
-         * - `<img src="image.jpg" alt="Description">` for images
-         * - `<input type="text" name="username">` for form inputs
+         * - `<br />` for line breaks
+         * - `<img src="image.jpg" alt="Description" />` for images
+         * - `<input type="text" name="username" />` for form inputs
          */
-        virtual std::string to_string() const override;
+        virtual bool write_open(output_sink &sink, const param_table *params) const override;
 
+    public:
         /**
          * @brief Override to return empty children collection.
          * @return Empty vector since self-closing elements cannot have children
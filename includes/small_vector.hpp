@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include <type_traits>
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Contiguous vector that stores its first N elements inline.
+     * @tparam T Element type
+     * @tparam N Number of elements stored without a heap allocation
+     *
+     * Behaves like a minimal std::vector, but the first N elements live
+     * inside the object itself. Containers that usually hold only a handful
+     * of items (such as element attributes) therefore need no heap
+     * allocation at all, and iteration always walks one contiguous array.
+     * Growing past N moves the elements into a heap buffer.
+     */
+    template <typename T, std::size_t N>
+    class small_vector
+    {
+        static_assert(N > 0, "small_vector needs at least one inline slot");
+
+        T *first;
+        // 32-bit sizes keep the header at 16 bytes
+        std::uint32_t count;
+        std::uint32_t cap;
+        alignas(T) unsigned char inline_storage[N * sizeof(T)];
+
+        T *inline_data() noexcept
+        {
+            return reinterpret_cast<T *>(inline_storage);
+        }
+
+        const T *inline_data() const noexcept
+        {
+            return reinterpret_cast<const T *>(inline_storage);
+        }
+
+        bool is_inline() const noexcept
+        {
+            return first == inline_data();
+        }
+
+        void release() noexcept
+        {
+            clear();
+            if (!is_inline())
+                ::operator delete(first);
+            first = inline_data();
+            cap = N;
+        }
+
+        void steal(small_vector &other) noexcept(std::is_nothrow_move_constructible<T>::value)
+        {
+            if (other.is_inline())
+            {
+                for (std::size_t i = 0; i < other.count; i++)
+                    new (first + i) T(std::move(other.first[i]));
+                count = other.count;
+                other.clear();
+            }
+            else
+            {
+                first = other.first;
+                count = other.count;
+                cap = other.cap;
+                other.first = other.inline_data();
+                other.count = 0;
+                other.cap = N;
+            }
+        }
+
+    public:
+        using value_type = T;
+        using iterator = T *;
+        using const_iterator = const T *;
+        using size_type = std::size_t;
+
+        small_vector() noexcept : first(inline_data()), count(0), cap(N) {}
+
+        small_vector(std::initializer_list<T> items) : small_vector()
+        {
+            reserve(items.size());
+            for (const auto &item : items)
+                push_back(item);
+        }
+
+        small_vector(const small_vector &other) : small_vector()
+        {
+            reserve(other.count);
+            for (const auto &item : other)
+                push_back(item);
+        }
+
+        small_vector(small_vector &&other) noexcept(std::is_nothrow_move_constructible<T>::value) : small_vector()
+        {
+            steal(other);
+        }
+
+        small_vector &operator=(const small_vector &other)
+        {
+            if (this != &other)
+            {
+                clear();
+                reserve(other.count);
+                for (const auto &item : other)
+                    push_back(item);
+            }
+            return *this;
+        }
+
+        small_vector &operator=(small_vector &&other) noexcept(std::is_nothrow_move_constructible<T>::value)
+        {
+            if (this != &other)
+            {
+                release();
+                steal(other);
+            }
+            return *this;
+        }
+
+        ~small_vector()
+        {
+            release();
+        }
+
+        iterator begin() noexcept { return first; }
+        iterator end() noexcept { return first + count; }
+        const_iterator begin() const noexcept { return first; }
+        const_iterator end() const noexcept { return first + count; }
+
+        std::size_t size() const noexcept { return count; }
+        std::size_t capacity() const noexcept { return cap; }
+        bool empty() const noexcept { return count == 0; }
+
+        T &operator[](std::size_t i) noexcept { return first[i]; }
+        const T &operator[](std::size_t i) const noexcept { return first[i]; }
+
+        /**
+         * @brief Make room for at least n elements.
+         * @param n Required capacity
+         */
+        void reserve(std::size_t n)
+        {
+            if (n <= cap)
+                return;
+            T *grown = static_cast<T *>(::operator new(n * sizeof(T)));
+            for (std::size_t i = 0; i < count; i++)
+            {
+                new (grown + i) T(std::move(first[i]));
+                first[i].~T();
+            }
+            if (!is_inline())
+                ::operator delete(first);
+            first = grown;
+            cap = static_cast<std::uint32_t>(n);
+        }
+
+        /**
+         * @brief Construct a new element at the end.
+         * @param args Constructor arguments forwarded to T
+         * @return Reference to the new element
+         */
+        template <typename... Args>
+        T &emplace_back(Args &&...args)
+        {
+            if (count == cap)
+            {
+                // Build the value first: args may refer to an element being moved
+                T value(std::forward<Args>(args)...);
+                reserve(cap * std::size_t(2) > N ? cap * std::size_t(2) : N + 1);
+                new (first + count) T(std::move(value));
+            }
+            else
+            {
+                new (first + count) T(std::forward<Args>(args)...);
+            }
+            return first[count++];
+        }
+
+        void push_back(const T &value) { emplace_back(value); }
+        void push_back(T &&value) { emplace_back(std::move(value)); }
+
+        /**
+         * @brief Remove the last element.
+         */
+        void pop_back() noexcept
+        {
+            first[--count].~T();
+        }
+
+        /**
+         * @brief Remove one element, keeping the order of the others.
+         * @param pos Element to remove
+         * @return Iterator to the element that followed the removed one
+         */
+        iterator erase(const_iterator pos)
+        {
+            T *target = first + (pos - first);
+            std::move(target + 1, end(), target);
+            first[count - 1].~T();
+            count--;
+            return target;
+        }
+
+        /**
+         * @brief Destroy all elements, keeping the allocated capacity.
+         */
+        void clear() noexcept
+        {
+            for (std::size_t i = 0; i < count; i++)
+                first[i].~T();
+            count = 0;
+        }
+    };
+}
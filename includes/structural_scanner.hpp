@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Bitmaps of the structural characters in one 64-byte block.
+     *
+     * Bit i of each mask is set when byte i of the block is the character.
+     */
+    struct structural_masks
+    {
+        std::uint64_t lt = 0;
+        std::uint64_t gt = 0;
+        std::uint64_t line_break = 0;
+    };
+
+    /**
+     * @brief Classify up to 64 bytes into structural bitmaps.
+     * @param data First byte of the block
+     * @param size Number of bytes to classify (at most 64)
+     * @return Masks of '<', '>' and '\n'
+     *
+     * Uses AVX2 or SSE2 compares, picked once at startup for the running
+     * CPU, and a table-driven loop on other platforms.
+     */
+    structural_masks classify_block(const char *data, std::size_t size);
+
+    /**
+     * @brief Forward scanner for '<', '>' and line breaks.
+     *
+     * The input is classified 64 bytes at a time into bitmaps (as in the
+     * first stage of simdjson), and searches are answered from the current
+     * block's bitmaps with count-trailing-zeros. Each byte is therefore
+     * classified once, however many searches pass over it, and whether a
+     * line break lies before a match comes for free from the same block.
+     *
+     * Example usage:
+     * ```cpp
+     * structural_scanner scanner(html);
+     * bool line_break = false;
+     * std::size_t lt = scanner.find('<', 0, line_break);
+     * ```
+     */
+    class structural_scanner
+    {
+        std::string_view input;
+        std::size_t block = SIZE_MAX;
+        structural_masks masks;
+
+        void load(std::size_t block_start)
+        {
+            block = block_start;
+            std::size_t remaining = input.size() - block_start;
+            masks = classify_block(input.data() + block_start, remaining < 64 ? remaining : 64);
+        }
+
+    public:
+        /**
+         * @brief Create a scanner over a buffer.
+         * @param input Buffer to scan (must outlive the scanner)
+         */
+        explicit structural_scanner(std::string_view input) : input(input) {}
+
+        /**
+         * @brief Find the next '<' or '>'.
+         * @param c '<' or '>'
+         * @param from Offset to search from
+         * @param line_break Set when a '\n' lies between from and the result
+         * @return Offset of c, or std::string_view::npos
+         */
+        std::size_t find(char c, std::size_t from, bool &line_break)
+        {
+            while (from < input.size())
+            {
+                std::size_t base = from & ~static_cast<std::size_t>(63);
+                if (base != block)
+                    load(base);
+
+                std::uint64_t live = ~std::uint64_t(0) << (from - base);
+                std::uint64_t hits = (c == '<' ? masks.lt : masks.gt) & live;
+                // Bits below the first hit, or the whole rest of the block
+                std::uint64_t before = hits != 0 ? (hits & (0 - hits)) - 1 : ~std::uint64_t(0);
+                if ((masks.line_break & live & before) != 0)
+                    line_break = true;
+                if (hits != 0)
+                    return base + static_cast<std::size_t>(__builtin_ctzll(hits));
+                from = base + 64;
+            }
+            return std::string_view::npos;
+        }
+    };
+}
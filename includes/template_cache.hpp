@@ -0,0 +1,204 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+#include "element.hpp"
+#include "compiled_template.hpp"
+#include "document_parser.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief One version of a template file, as held by template_cache.
+     *
+     * Shared by every caller that asked for the same version, and kept
+     * alive by them after the cache has replaced or evicted it.
+     */
+    struct cached_template
+    {
+        /// Parsed tree; shared, so read it but never modify it
+        std::vector<std::shared_ptr<element>> nodes;
+
+        /// Pre-serialized form of nodes for rendering with parameters
+        compiled_template compiled;
+
+        /// Hash of the file contents this version was parsed from
+        std::uint64_t hash;
+
+        /// Approximate bytes held: source text, node arena and compiled form
+        std::size_t memory;
+    };
+
+    /**
+     * @brief Cache of parsed template files, shared by all threads of a server.
+     *
+     * Maps a file path to its parsed tree and compiled_template, so a
+     * template is read and parsed once per version instead of once per
+     * request or worker. Each get() checks the file's modification time
+     * (with nanosecond resolution) and size with a single stat(). If either
+     * changed, the file is read again and hashed, and it is parsed only if
+     * its contents changed too; a file that was touched or rewritten with
+     * the same bytes keeps its cached version.
+     *
+     * Lookups of a cached, unchanged template take a shared lock and touch
+     * an atomic counter, so concurrent readers do not block each other.
+     * Loads of one path are serialized, and the file is parsed outside the
+     * cache-wide lock, so a slow parse delays only callers waiting for the
+     * same template. With a memory limit, the least recently used
+     * templates are evicted once the total goes over it.
+     *
+     * Example usage:
+     * ```cpp
+     * static template_cache templates(64 * 1024 * 1024);
+     *
+     * auto page = templates.get("templates/index.html");  // parsed on first use only
+     * std::string out = page->compiled.render({{"title", "Dashboard"}});
+     * ```
+     *
+     * @note Files are read into memory rather than mapped, so templates can
+     *       be edited or truncated while cached versions are in use
+     * @note Cached trees are shared between threads: render them, or copy()
+     *       before modifying, but never call set_params() and similar on them
+     * @note Two versions written within one timestamp tick and with the
+     *       same size are told apart only by the next change of either
+     */
+    class template_cache
+    {
+    public:
+        /// Counters of how lookups were answered
+        struct statistics
+        {
+            /// Lookups answered without reading the file
+            std::size_t hits = 0;
+
+            /// Files read again whose contents had not changed
+            std::size_t revalidations = 0;
+
+            /// Files parsed (first use or changed contents)
+            std::size_t parses = 0;
+
+            /// Templates dropped to stay under the memory limit
+            std::size_t evictions = 0;
+
+            /// Versions that failed to parse (each is parsed once)
+            std::size_t failures = 0;
+        };
+
+        /**
+         * @brief Create an empty cache.
+         * @param max_bytes Memory limit in bytes (see cached_template::memory),
+         *                  or 0 for no limit
+         * @param options Parse settings for every template; arena, zero_copy
+         *                and lazy are ignored, since each version gets its own
+         *                arena that retains its source
+         */
+        explicit template_cache(std::size_t max_bytes = 0, const parse_options &options = parse_options());
+        ~template_cache();
+
+        template_cache(const template_cache &) = delete;
+        template_cache &operator=(const template_cache &) = delete;
+
+        /**
+         * @brief Get the current version of a template, parsing it if needed.
+         * @param path Path of the template file
+         * @return Parsed template; stays valid however long it is held
+         *
+         * If a changed file fails to parse, the version cached earlier is
+         * returned instead, and keeps being returned until the file changes
+         * again; statistics::failures counts these. The broken version is
+         * parsed once: later calls see the same stamp and do not read it.
+         *
+         * @note Throws std::runtime_error if the file cannot be stat'ed or
+         *       read. A file that fails to parse with no earlier version
+         *       throws the parse error, and throws it again on every call
+         *       (without reading the file) until the file changes, so
+         *       callers must handle the exception on every request.
+         */
+        std::shared_ptr<const cached_template> get(const std::string &path);
+
+        /**
+         * @brief Drop a template from the cache.
+         * @param path Path passed to get()
+         * @return true if the template was cached
+         */
+        bool erase(const std::string &path);
+
+        /**
+         * @brief Drop every template.
+         */
+        void clear();
+
+        /**
+         * @brief Get the number of cached templates.
+         * @return Template count
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Get the memory held by the cached templates.
+         * @return Sum of cached_template::memory
+         */
+        std::size_t memory_usage() const;
+
+        /**
+         * @brief Get the lookup counters.
+         * @return Counts since the cache was created
+         */
+        statistics get_statistics() const;
+
+    private:
+        struct file_stamp
+        {
+            std::int64_t modified_ns = -1;
+            std::int64_t size = -1;
+
+            bool operator==(const file_stamp &other) const
+            {
+                return modified_ns == other.modified_ns && size == other.size;
+            }
+        };
+
+        struct slot;
+
+        std::size_t max_bytes;
+        parse_options options;
+
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<slot>> slots;
+        std::size_t bytes = 0;
+
+        std::atomic<std::uint64_t> clock{0};
+        std::atomic<std::size_t> hits{0};
+        std::atomic<std::size_t> revalidations{0};
+        std::atomic<std::size_t> parses{0};
+        std::atomic<std::size_t> evictions{0};
+        std::atomic<std::size_t> failures{0};
+
+        static file_stamp stat_file(const std::string &path);
+        static std::string read_file(const std::string &path, file_stamp &stamp);
+
+        void touch(slot &entry);
+        std::shared_ptr<const cached_template> cached_version(slot &entry, const file_stamp &stamp, std::exception_ptr &failure);
+        std::shared_ptr<const cached_template> load(const std::string &path, const std::shared_ptr<slot> &entry);
+        void evict_over_limit(const slot *keep);
+    };
+
+    /**
+     * @brief Hash a byte string for change detection.
+     * @param data Bytes to hash
+     * @return 64-bit hash
+     *
+     * Reads eight bytes per step, so whole files hash at memory speed.
+     * Not cryptographic: it detects edits, not deliberate collisions.
+     */
+    std::uint64_t content_hash(std::string_view data);
+}
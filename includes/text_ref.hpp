@@ -0,0 +1,190 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <utility>
+#include <ostream>
+#include <new>
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Text that is either owned or borrowed from a parse buffer.
+     *
+     * A zero-copy parse stores text content and attribute values as slices
+     * of the source buffer instead of allocating a string per slice. The
+     * buffer is kept alive by the node_arena the nodes were allocated from.
+     *
+     * Borrowed text is copied into owned storage the first time it is
+     * mutated (mutable_str()). Copying a text_ref always produces an owned
+     * copy, so element and attribute copies never outlive the buffer they
+     * point into; moving keeps the borrow.
+     */
+    class text_ref
+    {
+        // One of the two is active, as told by borrowed; sharing the storage
+        // keeps text_ref at the size of a std::string plus a flag
+        union
+        {
+            std::string owned;
+            std::string_view slice;
+        };
+        bool borrowed = false;
+
+        /// Switch from a borrowed slice to owned text
+        void own(std::string &&text) noexcept
+        {
+            new (&owned) std::string(std::move(text));
+            borrowed = false;
+        }
+
+        /// Make this text empty and owned, releasing nothing (for moved-from borrowed text)
+        void reset_borrowed() noexcept
+        {
+            own(std::string());
+        }
+
+    public:
+        text_ref() : owned() {}
+        text_ref(const std::string &text) : owned(text) {}
+        text_ref(std::string &&text) : owned(std::move(text)) {}
+        text_ref(const char *text) : owned(text) {}
+        explicit text_ref(std::string_view text) : owned(text.data(), text.size()) {}
+
+        /**
+         * @brief Make a text_ref that points into a buffer without copying it.
+         * @param text Slice of a buffer that outlives this text_ref
+         * @return Borrowed text_ref
+         */
+        static text_ref borrow(std::string_view text)
+        {
+            text_ref result;
+            result.owned.~basic_string();
+            new (&result.slice) std::string_view(text);
+            result.borrowed = true;
+            return result;
+        }
+
+        text_ref(const text_ref &other) : owned(other.view()) {}
+
+        text_ref(text_ref &&other) noexcept : borrowed(other.borrowed)
+        {
+            if (other.borrowed)
+            {
+                new (&slice) std::string_view(other.slice);
+                other.reset_borrowed();
+            }
+            else
+            {
+                new (&owned) std::string(std::move(other.owned));
+            }
+        }
+
+        ~text_ref()
+        {
+            if (!borrowed)
+                owned.~basic_string();
+        }
+
+        text_ref &operator=(const text_ref &other)
+        {
+            if (this != &other)
+                assign(other.view());
+            return *this;
+        }
+
+        text_ref &operator=(text_ref &&other) noexcept
+        {
+            if (this == &other)
+                return *this;
+            if (other.borrowed)
+            {
+                if (!borrowed)
+                    owned.~basic_string();
+                new (&slice) std::string_view(other.slice);
+                borrowed = true;
+                other.reset_borrowed();
+            }
+            else
+            {
+                *this = std::move(other.owned);
+            }
+            return *this;
+        }
+
+        text_ref &operator=(const std::string &text)
+        {
+            assign(text);
+            return *this;
+        }
+
+        text_ref &operator=(std::string &&text) noexcept
+        {
+            if (borrowed)
+                own(std::move(text));
+            else
+                owned = std::move(text);
+            return *this;
+        }
+
+        text_ref &operator=(const char *text)
+        {
+            assign(text);
+            return *this;
+        }
+
+        /**
+         * @brief Replace the text with an owned copy of a string.
+         * @param text New text (may point into this text_ref)
+         */
+        void assign(std::string_view text)
+        {
+            if (borrowed)
+                own(std::string(text.data(), text.size()));
+            else
+                owned.assign(text.data(), text.size());
+        }
+
+        /**
+         * @brief Get writable access, copying borrowed text into owned storage.
+         * @return Reference to the owned string
+         */
+        std::string &mutable_str()
+        {
+            if (borrowed)
+                own(std::string(slice.data(), slice.size()));
+            return owned;
+        }
+
+        std::string_view view() const
+        {
+            return borrowed ? slice : std::string_view(owned);
+        }
+
+        operator std::string_view() const { return view(); }
+
+        /// Copy of the text as a std::string
+        std::string str() const { return std::string(view()); }
+
+        /// Whether the text points into a parse buffer
+        bool is_borrowed() const { return borrowed; }
+
+        const char *data() const { return view().data(); }
+        std::size_t size() const { return borrowed ? slice.size() : owned.size(); }
+        bool empty() const { return size() == 0; }
+
+        friend bool operator==(const text_ref &a, const text_ref &b) { return a.view() == b.view(); }
+        friend bool operator!=(const text_ref &a, const text_ref &b) { return a.view() != b.view(); }
+        friend bool operator==(const text_ref &a, std::string_view b) { return a.view() == b; }
+        friend bool operator!=(const text_ref &a, std::string_view b) { return a.view() != b; }
+        friend bool operator==(std::string_view a, const text_ref &b) { return a == b.view(); }
+        friend bool operator!=(std::string_view a, const text_ref &b) { return a != b.view(); }
+        friend bool operator==(const text_ref &a, const char *b) { return a.view() == b; }
+        friend bool operator!=(const text_ref &a, const char *b) { return a.view() != b; }
+        friend bool operator==(const text_ref &a, const std::string &b) { return a.view() == b; }
+        friend bool operator!=(const text_ref &a, const std::string &b) { return a.view() != b; }
+
+        friend std::ostream &operator<<(std::ostream &out, const text_ref &text) { return out << text.view(); }
+    };
+}
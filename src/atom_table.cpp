@@ -0,0 +1,147 @@
+#include <mutex>
+#include <new>
+#include <cstring>
+
+#include "../includes/atom_table.hpp"
+
+namespace hh_html_builder
+{
+    namespace
+    {
+        /**
+         * Names interned when the table is created. Id 0 is the empty name
+         * used by text nodes; void elements come next so their ids form a
+         * small dense range.
+         */
+        const char *const seed_names[] = {
+            "",
+            // Void elements
+            "area", "base", "br", "col", "embed", "hr", "img", "input",
+            "link", "meta", "param", "source", "track", "wbr",
+            // Other elements
+            "!DOCTYPE", "a", "abbr", "address", "article", "aside", "audio", "b",
+            "bdi", "bdo", "blockquote", "body", "button", "canvas", "caption",
+            "cite", "code", "colgroup", "data", "datalist", "dd", "del",
+            "details", "dfn", "dialog", "div", "dl", "dt", "em", "fieldset",
+            "figcaption", "figure", "footer", "form", "h1", "h2", "h3", "h4",
+            "h5", "h6", "head", "header", "hgroup", "html", "i", "iframe", "ins",
+            "kbd", "label", "legend", "li", "main", "map", "mark", "menu",
+            "meter", "nav", "noscript", "object", "ol", "optgroup", "option",
+            "output", "p", "picture", "pre", "progress", "q", "rp", "rt", "ruby",
+            "s", "samp", "script", "search", "section", "select", "slot",
+            "small", "span", "strong", "style", "sub", "summary", "sup", "svg",
+            "table", "tbody", "td", "template", "textarea", "tfoot", "th",
+            "thead", "time", "title", "tr", "u", "ul", "var", "video", "path",
+            "g", "circle", "rect", "line", "polygon", "polyline", "use", "defs",
+            "math",
+            // Attributes
+            "accept", "accesskey", "action", "align", "allow", "alt", "async",
+            "autocomplete", "autofocus", "autoplay", "charset", "checked",
+            "class", "cols", "colspan", "content", "contenteditable", "controls",
+            "crossorigin", "d", "datetime", "decoding", "defer", "dir",
+            "disabled", "download", "draggable", "enctype", "fill", "for",
+            "height", "hidden", "href", "hreflang", "http-equiv", "id",
+            "integrity", "lang", "list", "loading", "loop", "max", "maxlength",
+            "media", "method", "min", "minlength", "multiple", "muted", "name",
+            "novalidate", "onblur", "onchange", "onclick", "onfocus", "oninput",
+            "onkeydown", "onkeyup", "onload", "onsubmit", "pattern",
+            "placeholder", "poster", "preload", "readonly", "referrerpolicy",
+            "rel", "required", "role", "rows", "rowspan", "sandbox", "scope",
+            "selected", "sizes", "spellcheck", "src", "srcdoc", "srcset",
+            "step", "stroke", "tabindex", "target", "translate", "type",
+            "value", "viewBox", "width", "wrap", "xmlns", "aria-label",
+            "aria-hidden", "aria-describedby", "aria-labelledby",
+            "aria-expanded", "aria-controls", "aria-current", "property",
+            "data-id"};
+    }
+
+    atom_table::atom_table()
+    {
+        seeded.reserve(sizeof(seed_names) / sizeof(seed_names[0]) * 2);
+        for (const char *name : seed_names)
+        {
+            // Skip duplicates so every seeded name keeps a single id
+            if (seeded.find(name) != seeded.end())
+                continue;
+            std::uint32_t id = append(name);
+            seeded.emplace(this->name(id), id);
+        }
+    }
+
+    atom_table::~atom_table()
+    {
+        for (auto &c : chunks)
+            delete c.load(std::memory_order_relaxed);
+    }
+
+    atom_table &atom_table::global()
+    {
+        static atom_table *table = new atom_table();
+        return *table;
+    }
+
+    std::uint32_t atom_table::append(std::string_view name)
+    {
+        std::uint32_t id = count.load(std::memory_order_relaxed);
+        if (id >= max_atoms)
+            return npos;
+
+        chunk *c = chunks[id >> chunk_bits].load(std::memory_order_relaxed);
+        if (c == nullptr)
+        {
+            c = new chunk();
+            chunks[id >> chunk_bits].store(c, std::memory_order_release);
+        }
+        c->names[id & (chunk_size - 1)].assign(name.data(), name.size());
+        count.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    std::uint32_t atom_table::find(std::string_view name) const
+    {
+        auto it = seeded.find(name);
+        if (it != seeded.end())
+            return it->second;
+
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto added_it = added.find(name);
+        return added_it != added.end() ? added_it->second : npos;
+    }
+
+    std::uint32_t atom_table::intern(std::string_view name)
+    {
+        std::uint32_t id = find(name);
+        if (id != npos)
+            return id;
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = added.find(name);
+        if (it != added.end())
+            return it->second;
+        id = append(name);
+        if (id != npos)
+            added.emplace(this->name(id), id);
+        return id;
+    }
+
+    std::uintptr_t atom::make_owned(std::string_view name)
+    {
+        void *memory = ::operator new(sizeof(owned_name) + name.size());
+        owned_name *block = new (memory) owned_name{{1}, name.size()};
+        std::memcpy(const_cast<char *>(block->data()), name.data(), name.size());
+        return reinterpret_cast<std::uintptr_t>(block);
+    }
+
+    void atom::release()
+    {
+        if (interned())
+            return;
+        owned_name *block = owned();
+        if (block->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            block->~owned_name();
+            ::operator delete(block);
+        }
+        bits = 1;
+    }
+}
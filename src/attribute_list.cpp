@@ -0,0 +1,301 @@
+#include <cstring>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../includes/attribute_list.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Check whether a character can appear in a canonical attribute name.
+     */
+    static bool is_name_char(char c)
+    {
+        switch (c)
+        {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\f':
+        case '\r':
+        case '/':
+        case '=':
+        case '"':
+        case '\'':
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    attribute_list::attribute_list(std::initializer_list<std::pair<std::string_view, std::string_view>> attributes)
+    {
+        items.reserve(attributes.size());
+        for (const auto &attr : attributes)
+            append(atom(attr.first), text_ref(attr.second));
+        remove_duplicates();
+    }
+
+    attribute_list::attribute_list(const std::map<std::string, std::string> &attributes)
+    {
+        items.reserve(attributes.size());
+        for (const auto &attr : attributes)
+            items.emplace_back(atom(attr.first), attr.second);
+    }
+
+    attribute_list::iterator attribute_list::find(std::string_view name)
+    {
+        // Comparing a few short names is cheaper than a trip through the atom table
+        for (auto &attr : items)
+        {
+            if (attr.first.view() == name)
+                return &attr;
+        }
+        return items.end();
+    }
+
+    attribute_list::const_iterator attribute_list::find(std::string_view name) const
+    {
+        for (const auto &attr : items)
+        {
+            if (attr.first.view() == name)
+                return &attr;
+        }
+        return items.end();
+    }
+
+    attribute_list::iterator attribute_list::find(atom name)
+    {
+        for (auto &attr : items)
+        {
+            if (attr.first == name)
+                return &attr;
+        }
+        return items.end();
+    }
+
+    attribute_list::const_iterator attribute_list::find(atom name) const
+    {
+        for (const auto &attr : items)
+        {
+            if (attr.first == name)
+                return &attr;
+        }
+        return items.end();
+    }
+
+    const text_ref *attribute_list::get(std::string_view name) const
+    {
+        auto it = find(name);
+        return it != end() ? &it->second : nullptr;
+    }
+
+    void attribute_list::set(std::string_view name, std::string_view value)
+    {
+        set(atom(name), value);
+    }
+
+    void attribute_list::set(atom name, std::string_view value)
+    {
+        auto it = find(name);
+        if (it != end())
+            it->second.assign(value);
+        else
+            items.emplace_back(name, text_ref(value));
+    }
+
+    void attribute_list::set(atom name, text_ref &&value)
+    {
+        auto it = find(name);
+        if (it != end())
+            it->second = std::move(value);
+        else
+            items.emplace_back(name, std::move(value));
+    }
+
+    void attribute_list::append(atom name, text_ref &&value)
+    {
+        items.emplace_back(name, std::move(value));
+    }
+
+    void attribute_list::remove_duplicates()
+    {
+        // Up to this many attributes, comparing every pair is cheapest
+        constexpr std::size_t pairwise_limit = 16;
+        const std::size_t count = items.size();
+        if (count < 2)
+            return;
+
+        // Move each attribute down to `kept`, or merge it into the first attribute of its name
+        std::size_t kept = 0;
+        auto keep = [&](std::size_t i)
+        {
+            if (kept != i)
+                items[kept] = std::move(items[i]);
+            kept++;
+        };
+
+        if (count <= pairwise_limit)
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                std::size_t k = 0;
+                while (k < kept && items[k].first != items[i].first)
+                    k++;
+                if (k < kept)
+                    items[k].second = std::move(items[i].second);
+                else
+                    keep(i);
+            }
+        }
+        else
+        {
+            // Open-addressed index from name to its kept position, load factor at most one half
+            std::size_t capacity = 64;
+            while (capacity < count * 2)
+                capacity <<= 1;
+            const std::size_t mask = capacity - 1;
+            std::vector<std::uint32_t> slots(capacity, UINT32_MAX);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                std::size_t index = std::hash<std::string_view>()(items[i].first.view()) & mask;
+                while (slots[index] != UINT32_MAX && items[slots[index]].first != items[i].first)
+                    index = (index + 1) & mask;
+                if (slots[index] != UINT32_MAX)
+                {
+                    items[slots[index]].second = std::move(items[i].second);
+                }
+                else
+                {
+                    slots[index] = static_cast<std::uint32_t>(kept);
+                    keep(i);
+                }
+            }
+        }
+
+        while (items.size() > kept)
+            items.pop_back();
+    }
+
+    std::string &attribute_list::operator[](std::string_view name)
+    {
+        atom key(name);
+        auto it = find(key);
+        if (it != end())
+            return it->second.mutable_str();
+        return items.emplace_back(key, text_ref()).second.mutable_str();
+    }
+
+    std::size_t attribute_list::erase(std::string_view name)
+    {
+        auto it = find(name);
+        if (it == end())
+            return 0;
+        items.erase(it);
+        return 1;
+    }
+
+    void attribute_list::clear()
+    {
+        items.clear();
+    }
+
+    attribute_list::operator std::map<std::string, std::string>() const
+    {
+        std::map<std::string, std::string> result;
+        for (const auto &attr : items)
+            result.emplace(attr.first.str(), attr.second.str());
+        return result;
+    }
+
+    bool attribute_list::is_canonical_text(std::string_view text)
+    {
+        // Tags with more attributes than this are rare; they are simply parsed
+        constexpr std::size_t max_names = 16;
+        std::string_view names[max_names];
+        std::size_t count = 0;
+
+        const char *data = text.data();
+        const std::size_t size = text.size();
+        std::size_t i = 0;
+        while (i < size)
+        {
+            std::size_t name_start = i;
+            while (i < size && is_name_char(data[i]))
+                i++;
+            // An empty name means extra whitespace or a stray '/', '=' or quote
+            if (i == name_start || count == max_names)
+                return false;
+            std::string_view name(data + name_start, i - name_start);
+            for (std::size_t k = 0; k < count; k++)
+            {
+                if (names[k] == name)
+                    return false;
+            }
+            names[count++] = name;
+
+            if (i < size && data[i] == '=')
+            {
+                // Only a non-empty double-quoted value renders as written
+                if (i + 2 >= size || data[i + 1] != '"' || data[i + 2] == '"')
+                    return false;
+                const char *close = static_cast<const char *>(std::memchr(data + i + 2, '"', size - i - 2));
+                if (close == nullptr)
+                    return false;
+                i = static_cast<std::size_t>(close - data) + 1;
+            }
+
+            if (i == size)
+                return true;
+            if (data[i] != ' ' || i + 1 == size)
+                return false;
+            i++;
+        }
+        return true;
+    }
+
+    bool attribute_list::next_canonical(std::string_view text, std::size_t &pos, std::string_view &name, std::string_view &value)
+    {
+        if (pos >= text.size())
+            return false;
+        std::size_t name_end = text.find_first_of("= ", pos);
+        if (name_end == std::string_view::npos)
+            name_end = text.size();
+        name = text.substr(pos, name_end - pos);
+        value = std::string_view();
+        pos = name_end;
+        if (pos < text.size() && text[pos] == '=')
+        {
+            std::size_t close = text.find('"', pos + 2);
+            value = text.substr(pos + 2, close - pos - 2);
+            pos = close + 1;
+        }
+        // Skip the separating space
+        pos++;
+        return true;
+    }
+
+    attribute_list attribute_list::from_canonical_text(std::string_view text, bool borrow)
+    {
+        attribute_list attributes;
+        std::string_view name, value;
+        for (std::size_t pos = 0; next_canonical(text, pos, name, value);)
+            attributes.items.emplace_back(atom(name), borrow ? text_ref::borrow(value) : text_ref(value));
+        return attributes;
+    }
+
+    bool attribute_list::operator==(const attribute_list &other) const
+    {
+        if (size() != other.size())
+            return false;
+        for (const auto &attr : items)
+        {
+            auto it = other.find(attr.first);
+            const text_ref *value = it != other.end() ? &it->second : nullptr;
+            if (value == nullptr || *value != attr.second)
+                return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,157 @@
+#include "../includes/compiled_template.hpp"
+
+namespace hh_html_builder
+{
+    compiled_template::compiled_template(const element &root)
+    {
+        compile(root.to_string());
+    }
+
+    compiled_template::compiled_template(const std::vector<std::shared_ptr<element>> &elements)
+    {
+        std::string serialized;
+        string_sink sink(serialized);
+        for (const auto &elem : elements)
+        {
+            if (elem)
+                elem->write_to(sink);
+        }
+        compile(serialized);
+    }
+
+    compiled_template::compiled_template(const document &doc)
+    {
+        compile(doc.to_string());
+    }
+
+    /**
+     * @brief Split serialized HTML into static runs and `{{name}}` slots.
+     * @param serialized Fully rendered template text
+     *
+     * Scans the text once. Each `{{` that has a matching `}}` becomes a slot
+     * named by the text in between; everything else is copied into the static
+     * buffer. When several `{{` precede the same `}}` (as in `{{{name}}}`) the
+     * innermost one opens the slot, so the slot name matches what
+     * parse_html_with_params() would look up.
+     */
+    void compiled_template::compile(const std::string &serialized)
+    {
+        static_bytes.reserve(serialized.size());
+
+        // Track whether the scan is inside a tag so each slot knows its context
+        bool in_tag = false;
+        bool in_quotes = false;
+        size_t scanned = 0;
+        auto advance_context = [&](size_t until)
+        {
+            for (; scanned < until; scanned++)
+            {
+                char c = serialized[scanned];
+                if (!in_tag)
+                    in_tag = c == '<';
+                else if (c == '"')
+                    in_quotes = !in_quotes;
+                else if (c == '>' && !in_quotes)
+                    in_tag = false;
+            }
+        };
+
+        size_t pos = 0;
+        size_t run_start = 0;
+        while ((pos = serialized.find("{{", pos)) != std::string::npos)
+        {
+            size_t name_end = serialized.find("}}", pos + 2);
+            if (name_end == std::string::npos)
+                break;
+
+            // The innermost "{{" before the closing braces opens the slot
+            size_t open = serialized.rfind("{{", name_end - 2);
+            size_t name_start = open + 2;
+
+            advance_context(open);
+            segments.push_back({static_bytes.size(), open - run_start, slot_names.size()});
+            static_bytes.append(serialized, run_start, open - run_start);
+            slot_names.push_back(serialized.substr(name_start, name_end - name_start));
+            slot_contexts.push_back(in_tag ? escape_context::attribute : escape_context::text);
+
+            pos = run_start = name_end + 2;
+        }
+
+        if (run_start < serialized.size() || segments.empty())
+        {
+            segments.push_back({static_bytes.size(), serialized.size() - run_start, npos});
+            static_bytes.append(serialized, run_start, std::string::npos);
+        }
+        static_bytes.shrink_to_fit();
+    }
+
+    void compiled_template::render(const param_table &params, output_sink &sink) const
+    {
+        const char *base = static_bytes.data();
+        for (const auto &seg : segments)
+        {
+            sink.write(base + seg.offset, seg.length);
+            if (seg.slot == npos)
+                continue;
+
+            const std::string &name = slot_names[seg.slot];
+            const std::string *value = params.find(name);
+            if (value != nullptr)
+            {
+                if (params.escapes_values())
+                    write_escaped(sink, *value, slot_contexts[seg.slot]);
+                else
+                    sink.write(*value);
+            }
+            else
+            {
+                sink.write("{{", 2);
+                sink.write(name);
+                sink.write("}}", 2);
+            }
+        }
+    }
+
+    void compiled_template::render(const std::map<std::string, std::string> &params, output_sink &sink, bool escape_values) const
+    {
+        param_table table(params, escape_values);
+        render(table, sink);
+    }
+
+    std::size_t compiled_template::rendered_size(const param_table &params) const
+    {
+        std::size_t total = static_bytes.size();
+        for (size_t i = 0; i < slot_names.size(); i++)
+        {
+            const std::string *value = params.find(slot_names[i]);
+            if (value == nullptr)
+                total += slot_names[i].size() + 4;
+            else if (params.escapes_values())
+                total += escaped_size(*value, slot_contexts[i]);
+            else
+                total += value->size();
+        }
+        return total;
+    }
+
+    std::size_t compiled_template::rendered_size(const std::map<std::string, std::string> &params, bool escape_values) const
+    {
+        param_table table(params, escape_values);
+        return rendered_size(table);
+    }
+
+    std::string compiled_template::render(const std::map<std::string, std::string> &params, bool escape_values) const
+    {
+        param_table table(params, escape_values);
+        std::string result;
+        result.reserve(rendered_size(table));
+        string_sink sink(result);
+        render(table, sink);
+        return result;
+    }
+
+    const std::vector<std::string> &compiled_template::get_slot_names() const
+    {
+        return slot_names;
+    }
+}
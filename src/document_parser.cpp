@@ -7,178 +7,171 @@
 #include <stack>
 #include <sstream>
 #include <set>
+#include <vector>
+#include <array>
 #include <cctype>
 
 #include <thread>
 #include <chrono>
+#include <functional>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <system_error>
 
 #include "../includes/document_parser.hpp"
 #include "../includes/element.hpp"
 #include "../includes/doctype_element.hpp"
 #include "../includes/self_closing_element.hpp"
+#include "../includes/param_table.hpp"
+#include "../includes/node_arena.hpp"
+#include "../includes/atom_table.hpp"
+#include "../includes/html_tokenizer.hpp"
+#include "../includes/html_handler.hpp"
+#include "../includes/mapped_file.hpp"
+#include "../includes/lazy_element.hpp"
+
 namespace hh_html_builder
 {
-    /**
-     * @brief Check if HTML string contains a DOCTYPE declaration.
-     * @param html HTML string to check
-     * @return true if DOCTYPE is found, false otherwise
-     */
-    bool has_doctype(const std::string &html)
+    /// Character classes seen by the attribute lexer
+    enum attribute_char : unsigned char
     {
-        return html.find("<!doctype") != std::string::npos;
-    }
-
-    /**
-     * @brief Extract and remove DOCTYPE declaration from HTML string.
-     * @param html HTML string (modified by removing the DOCTYPE)
-     * @return Extracted DOCTYPE string, or empty string if not found
-     *
-     * Finds the DOCTYPE declaration, extracts it, and removes it from the
-     * original HTML string to prepare for further parsing.
-     */
-    std::string extract_doctype(std::string &html)
-    {
-        size_t start = html.find("<!doctype");
-        if (start == std::string::npos)
-            return "";
-
-        size_t end = html.find('>', start);
-        if (end == std::string::npos)
-            return "";
-        // remove it form the html itself
-        auto doctype = html.substr(start, end - start + 1);
-        html.erase(start, end - start + 1);
-        return doctype;
-    }
+        attr_name = 0,   // anything that can appear in a name or unquoted value
+        attr_space = 1,  // tab, line feed, form feed, carriage return, space
+        attr_slash = 2,  // '/', ignored between attributes
+        attr_equals = 4, // '=', separates a name from its value
+        attr_quote = 8   // '"' or '\'', opens a quoted value
+    };
 
-    /**
-     * @brief Convert all HTML tag names to lowercase for consistent parsing.
-     * @param html HTML string to modify (tags are converted to lowercase)
-     *
-     * Normalizes HTML by converting tag names to lowercase while preserving
-     * attribute values, classes, and other content. This ensures consistent
-     * parsing regardless of the original case used in the HTML.
-     */
-    void transform_tags_to_lower_case(std::string &html)
+    static constexpr std::array<unsigned char, 256> make_attribute_classes()
     {
-        size_t pos = 0;
-        while ((pos = html.find('<', pos)) != std::string::npos)
-        {
-            size_t end_pos = html.find('>', pos);
-            if (end_pos == std::string::npos)
-                break;
-
-            // do not decapitalize the attribute names, classes, and so on,
-            size_t __end_pos = html.find(' ', pos + 1);
-            if (__end_pos == std::string::npos)
-                __end_pos = end_pos;
-            __end_pos = std::min(__end_pos, end_pos);
-
-            std::string tag = html.substr(pos + 1, __end_pos - pos - 1);
-            std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
-            html.replace(pos + 1, __end_pos - pos - 1, tag);
-            pos = end_pos + 1;
-        }
+        std::array<unsigned char, 256> classes = {};
+        for (unsigned char c : {'\t', '\n', '\f', '\r', ' '})
+            classes[c] = attr_space;
+        classes['/'] = attr_slash;
+        classes['='] = attr_equals;
+        classes['"'] = attr_quote;
+        classes['\''] = attr_quote;
+        return classes;
     }
 
-    /**
-     * @brief Remove leading and trailing whitespace from a string.
-     * @param str String to trim
-     * @return Trimmed string with whitespace removed from both ends
-     */
-    std::string trim(std::string &str)
+    static constexpr std::array<unsigned char, 256> attribute_classes = make_attribute_classes();
+
+    static unsigned char attribute_class(char c)
     {
-        size_t start = str.find_first_not_of(" \t\n\r");
-        if (start == std::string::npos)
-            return "";
-        size_t end = str.find_last_not_of(" \t\n\r");
-        return str.substr(start, end - start + 1);
+        return attribute_classes[static_cast<unsigned char>(c)];
     }
 
     /**
-     * @brief Remove all line break characters from HTML string.
-     * @param html HTML string to modify (line breaks are removed)
+     * @brief Parse an attribute string into name/value slices.
+     * @param attr_string Attribute text (not modified)
+     * @param borrow Store values as slices of attr_string instead of copies
+     * @param attributes Receives the attributes in source order
      *
-     * Removes all '\n' characters to create a single-line HTML string,
-     * which simplifies parsing by eliminating line-based formatting.
-     */
-    void remove_all_line_breaks(std::string &html)
-    {
-        html.erase(std::remove(html.begin(), html.end(), '\n'), html.end());
-    }
-    /**
-     * @brief Parse HTML attribute string into key-value pairs.
-     * @param attr_string String containing HTML attributes to parse
-     * @return Map of attribute names to their values
+     * A single forward pass through the states of the HTML attribute
+     * syntax (before name, name, after name, before value, value), where
+     * every decision is one lookup in attribute_classes. Names and values
+     * are emitted as ranges of attr_string; nothing is allocated except the
+     * attribute list itself (and the values, unless borrowed).
      *
-     *  Parser that handles various attribute formats:
-     * - Simple attributes: class="value" id="test"
-     * - Boolean attributes: disabled checked
-     * - Quoted values with spaces and special characters
-     * - Proper handling of equals signs and quote escaping
+     * Accepts every value syntax: `a="x"`, `a='x'`, `a=x` and a bare `a`,
+     * with whitespace allowed around '='. A value whose closing quote is
+     * missing runs to the end of the tag. Values are stored as written
+     * (character references are not decoded); since values render between
+     * double quotes, a '"' inside a single-quoted or unquoted value is
+     * stored as `&quot;`, which means the same thing.
      */
-    std::map<std::string, std::string> parse_attributes(std::string &attr_string)
+    static void parse_attribute_slices(std::string_view attr_string, bool borrow, attribute_list &attributes)
     {
-        std::map<std::string, std::string> attributes;
-
-        if (attr_string.empty())
-            return attributes;
-        attr_string = trim(attr_string);
-        std::string current = "";
-        bool did_open_an_attribute = false;
+        const char *data = attr_string.data();
+        const size_t size = attr_string.size();
+        size_t i = 0;
 
-        std::string current_key = "";
-        for (int i = 0; i < static_cast<int>(attr_string.size()); i++)
+        auto add = [&](std::string_view name, std::string_view value, bool double_quoted)
         {
-            char c = attr_string[i];
-            if (c == '=' && !did_open_an_attribute)
-            {
-                current_key = trim(current);
-                current = "";
-            }
-            else
+            if (double_quoted || value.find('"') == std::string_view::npos)
             {
-                current += c;
+                attributes.append(atom(name), borrow ? text_ref::borrow(value) : text_ref(value));
+                return;
             }
-            if (c == '"')
+            std::string escaped;
+            escaped.reserve(value.size() + 8);
+            for (char c : value)
             {
-                if (did_open_an_attribute)
-                {
-                    did_open_an_attribute = false;
-                    current.erase(current.begin());
-                    current.pop_back();
-                    attributes[current_key] = current;
-                    current = "";
-                    current_key = "";
-                }
+                if (c == '"')
+                    escaped += "&quot;";
                 else
-                {
-                    did_open_an_attribute = true;
-                }
+                    escaped += c;
             }
-            else if (!did_open_an_attribute && (c == ' ' || c == '\t' || c == '\n'))
+            attributes.append(atom(name), text_ref(std::move(escaped)));
+        };
+
+        while (true)
+        {
+            // Before name: whitespace and stray '/' separate attributes
+            while (i < size && (attribute_class(data[i]) & (attr_space | attr_slash)))
+                i++;
+            if (i >= size)
+                break;
+
+            // Name: the first character is taken as is, so a stray '=' or quote starts a name
+            size_t name_start = i++;
+            while (i < size && !(attribute_class(data[i]) & (attr_space | attr_slash | attr_equals)))
+                i++;
+            std::string_view name(data + name_start, i - name_start);
+
+            // After name: a value follows only if the next non-space character is '='
+            while (i < size && attribute_class(data[i]) == attr_space)
+                i++;
+            if (i >= size || data[i] != '=')
             {
-                current_key = trim(current);
-                current = "";
-                if (!current_key.empty())
-                    attributes[current_key] = "";
-                current_key = "";
+                attributes.append(atom(name), text_ref());
+                continue;
             }
-        }
+            i++;
 
-        if (current.size())
-        {
-            current_key = trim(current);
-            if (!current_key.empty())
+            // Before value
+            while (i < size && attribute_class(data[i]) == attr_space)
+                i++;
+
+            if (i < size && attribute_class(data[i]) == attr_quote)
+            {
+                // Quoted value: only the matching quote ends it
+                const char *close = static_cast<const char *>(std::memchr(data + i + 1, data[i], size - i - 1));
+                size_t value_end = close ? static_cast<size_t>(close - data) : size;
+                add(name, std::string_view(data + i + 1, value_end - i - 1), data[i] == '"');
+                i = value_end + 1;
+            }
+            else
             {
-                attributes[current_key] = "";
+                // Unquoted value: runs to the next whitespace
+                size_t value_start = i;
+                while (i < size && attribute_class(data[i]) != attr_space)
+                    i++;
+                add(name, std::string_view(data + value_start, i - value_start), false);
             }
         }
 
-        attributes.erase("");
-        attributes.erase("/");
-        attributes.erase(" ");
+        // Repeated names were appended as found; merge them once, as set() would have
+        attributes.remove_duplicates();
+    }
 
+    /**
+     * @brief Parse HTML attribute string into key-value pairs.
+     * @param attr_string String containing HTML attributes to parse
+     * @return Attribute names and values in source order
+     *
+     *  Parser that handles various attribute formats:
+     * - Simple attributes: class="value" id="test"
+     * - Single-quoted and unquoted values: class='value' id=test
+     * - Boolean attributes: disabled checked
+     * - Quoted values with spaces and special characters
+     * - Whitespace around equals signs
+     */
+    attribute_list parse_attributes(std::string &attr_string)
+    {
+        attribute_list attributes;
+        parse_attribute_slices(attr_string, false, attributes);
         return attributes;
     }
 
@@ -197,128 +190,478 @@ namespace hh_html_builder
     }
 
     /**
-     * @brief Check if a given tag name is a self-closing HTML element.
-     * @param tag Tag name to check
-     * @return true if the tag is self-closing, false otherwise
+     * @brief Look up the id of a closing tag's name without interning it.
+     * @param name Lowercase tag name
+     * @return Its atom id, or atom_table::npos if the name is not interned
      */
-    bool is_self_closing_tag(std::string &tag)
+    static std::uint32_t closing_id(std::string_view name)
     {
-        static std::set<std::string> self_closing_tags = get_self_closing_tags();
-        std::string lower_tag = tag;
-        std::transform(lower_tag.begin(), lower_tag.end(), lower_tag.begin(), ::tolower);
-        return self_closing_tags.find(lower_tag) != self_closing_tags.end();
+        atom found;
+        return atom::try_find(name, found) ? found.id() : atom_table::npos;
     }
+
     /**
-     * @brief Check if a tag string represents a closing tag.
-     * @param tag Tag string to check
-     * @return true if it's a closing tag (starts with /), false otherwise
+     * @brief Check whether a closing tag matches an open element.
+     * @param open Tag of the open element
+     * @param id Id of the closing tag's name, from closing_id()
+     * @param name Name of the closing tag
+     *
+     * Interned tags compare by id; the name is compared only for a tag that
+     * did not fit in the atom table, and so has none.
      */
-    bool is_closing_tag(std::string &tag)
+    static bool closes(const atom &open, std::uint32_t id, std::string_view name)
     {
-        return tag.size() > 1 && tag[0] == '/' && tag[1] != '/';
+        if (open.id() != atom_table::npos)
+            return open.id() == id;
+        return open == name;
     }
+
     /**
-     * @brief Separate tag name from its attributes in a tag content string.
-     * @param tag_content Full tag content (e.g., "div class='container' id='main'")
-     * @return Pair containing tag name and attributes string
+     * @brief Check if an interned tag name is a self-closing HTML element.
+     * @param tag Interned (lowercase) tag name
+     * @return true if the tag is self-closing, false otherwise
+     *
+     * Void elements are pre-seeded in the atom table, so their ids are small
+     * and the check is a single indexed load.
      */
-    std::pair<std::string, std::string> extract_tag_and_attributes(std::string &tag_content)
+    static bool is_self_closing_atom(const atom &tag)
     {
-        size_t space_pos = tag_content.find(' ');
-        if (space_pos == std::string::npos)
+        static const std::vector<bool> void_ids = []
         {
-            return {tag_content, ""};
-        }
+            std::vector<bool> ids;
+            for (const auto &name : get_self_closing_tags())
+            {
+                std::uint32_t id = atom(name).id();
+                if (id >= ids.size())
+                    ids.resize(id + 1, false);
+                ids[id] = true;
+            }
+            return ids;
+        }();
+        return tag.id() < void_ids.size() && void_ids[tag.id()];
+    }
 
-        std::string tag_name = tag_content.substr(0, space_pos);
-        std::string attributes = tag_content.substr(space_pos + 1);
-        return {tag_name, attributes};
+    /**
+     * @brief Check whether an element's text is kept as written when collapsing whitespace.
+     */
+    static bool is_preformatted_atom(const atom &tag)
+    {
+        static const atom pre("pre"), textarea("textarea"), script("script"), style("style");
+        return tag == pre || tag == textarea || tag == script || tag == style;
     }
+
+    static bool is_collapsible_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+    }
+
     /**
-     * @brief Remove all HTML comments from the HTML string.
-     * @param html HTML string to modify (comments are removed)
-     *
-     * Finds and removes all HTML comments (<!-- comment -->) from the string.
-     * Throws runtime_error if a comment is malformed (missing closing tag).
+     * @brief Check whether text has whitespace that collapsing would change.
+     * @return true if text has a whitespace character other than ' ', or two in a row
      */
-    void remove_all_comments(std::string &html)
+    static bool has_whitespace_run(std::string_view text)
     {
-        size_t pos = 0;
-        while ((pos = html.find("<!--", pos)) != std::string::npos)
+        for (size_t i = 0; i < text.size(); i++)
         {
-            size_t end_pos = html.find("-->", pos + 4);
-            if (end_pos == std::string::npos)
-                throw std::runtime_error("Malformed comment: no closing tag found");
-            html.erase(pos, end_pos - pos + 3);
+            if (is_collapsible_space(text[i]) && (text[i] != ' ' || (i + 1 < text.size() && is_collapsible_space(text[i + 1]))))
+                return true;
         }
+        return false;
     }
+
     /**
-     * @brief Read the content of an HTML tag starting at a given position.
-     * @param html HTML string to read from
-     * @param pos Reference to current position (updated to closing '>')
-     * @return Tag content between < and >
-     *
-     * Extracts tag content and updates the position to the closing '>'.
-     * Throws runtime_error if no closing '>' is found.
+     * @brief Append text with each run of whitespace replaced by a single space.
+     * @param text Text to append
+     * @param out String to append to; a run at the start of text is dropped
+     *            if out already ends with a space
      */
-    std::string read_tag(const std::string &html, size_t &pos)
+    static void append_collapsed(std::string_view text, std::string &out)
     {
-        size_t start = pos + 1;
-        size_t end = html.find('>', start);
-        if (end == std::string::npos)
+        size_t i = 0;
+        while (i < text.size())
         {
-            throw std::runtime_error("Malformed HTML: no closing '>' found");
+            if (!is_collapsible_space(text[i]))
+            {
+                out += text[i++];
+                continue;
+            }
+            if (out.empty() || out.back() != ' ')
+                out += ' ';
+            while (i < text.size() && is_collapsible_space(text[i]))
+                i++;
         }
-
-        std::string tag = html.substr(start, end - start);
-        pos = end; // Update position to the closing '>'
-        return tag;
     }
+
     /**
-     * @brief Extract just the tag name from a tag string that may include attributes.
-     * @param tag_with_atrs Tag string potentially containing attributes
-     * @return Clean tag name without attributes
-     *
-     * Separates the tag name from any attributes by finding the first whitespace.
+     * @brief Turn tokens into handler events until the input ends or the handler stops.
+     * @param tokenizer Source of tokens
+     * @param handler Receives the events
+     * @param attributes Reused storage for the attributes of each opening tag
+     * @param stop_offset Receives the offset of the token the handler stopped at
+     * @return true if the handler stopped the parse, false at end of input
      */
-    std::string fix_tag(std::string &tag_with_atrs)
+    static bool dispatch_tokens(html_tokenizer &tokenizer, html_handler &handler, attribute_list &attributes, size_t &stop_offset)
     {
-        std::string tag_name;
-        for (size_t i = 0; i < tag_with_atrs.size(); ++i)
+        html_token token;
+        while (tokenizer.next(token))
         {
-            if (tag_with_atrs[i] == ' ' || tag_with_atrs[i] == '\t' || tag_with_atrs[i] == '\n')
+            switch (token.type)
             {
-                tag_name = tag_with_atrs.substr(0, i);
-                return tag_name;
+            case token_type::text:
+                handler.on_text(token.content);
+                break;
+
+            case token_type::doctype:
+                handler.on_doctype(token.content);
+                break;
+
+            case token_type::close_tag:
+                handler.on_close(token.name);
+                break;
+
+            case token_type::open_tag:
+                if (handler.wants_raw_attributes())
+                {
+                    handler.on_open_raw(token.name, token.content);
+                    break;
+                }
+                attributes.clear();
+                if (!token.content.empty())
+                    parse_attribute_slices(token.content, true, attributes);
+                handler.on_open(token.name, attributes);
+                break;
+            }
+
+            if (handler.stopped())
+            {
+                stop_offset = token.offset;
+                return true;
             }
         }
+        return false;
+    }
 
-        return tag_with_atrs;
+    std::size_t parse_html_events(std::string_view html, html_handler &handler)
+    {
+        handler.resume();
+        html_tokenizer tokenizer(html);
+        attribute_list attributes;
+        size_t stop_offset = html.size();
+        dispatch_tokens(tokenizer, handler, attributes, stop_offset);
+        return stop_offset;
     }
 
     /**
-     * @brief Main recursive HTML parsing wrapper function.
-     * @param html HTML string to parse
-     * @return Vector of parsed element objects
-     * @note Optimized to run in O(n) time complexity using single-pass parsing.
+     * @brief Event handler that builds the element tree.
+     *
+     * Non-recursive: open elements are kept on an explicit stack, and every
+     * node is attached to its parent as soon as it is created, so memory and
+     * time grow linearly with nesting depth and no child vectors are copied.
+     * State lives in the builder rather than on the call stack, so events
+     * can be fed in any number of batches.
      *
-     * Entry point for the recursive HTML parser. Delegates to the optimized
-     * parsing algorithm that processes the entire HTML string in linear time.
+     * A top-level node is complete once its closing tag has been consumed
+     * (immediately for text and void elements); complete nodes go to
+     * on_node if set, otherwise they are collected in result. A closing tag
+     * with no open element stops the parse.
+     *
+     * Opening tags arrive with their attribute text unparsed. Text that is
+     * already in rendered form (see attribute_list::is_canonical_text()) is
+     * stored on the element as is and parsed only if someone asks for the
+     * attributes; other text is parsed right away.
      */
-    std::vector<std::shared_ptr<element>> solve_recursive(std::string &html)
+    struct tree_builder : html_handler
     {
-        return parse_html_optimized(html, 0, html.length()).first;
-    }
+        struct open_element
+        {
+            element *node;
+            atom tag;
+        };
+
+        /// Arena to allocate nodes from, or nullptr for the heap
+        std::shared_ptr<node_arena> arena;
+
+        /// Buffer whose slices may be borrowed instead of copied (zero-copy parses)
+        std::string_view source;
+
+        /// Receives complete top-level nodes (and the DOCTYPE) when set
+        std::function<void(std::shared_ptr<element>)> on_node;
+
+        /// Complete top-level nodes, when on_node is not set
+        std::vector<std::shared_ptr<element>> result;
+
+        /// First DOCTYPE declaration seen, hoisted to the front of the result
+        std::shared_ptr<element> doctype;
+
+        /// Top-level element whose closing tag has not been consumed yet
+        std::shared_ptr<element> root;
+
+        /// Depth below the top level whose complete nodes also go to on_node, detached (0 = none)
+        size_t emit_depth = 0;
+
+        /// Open element at emit_depth, held here instead of by its parent
+        std::shared_ptr<element> streamed;
+
+        std::vector<open_element> open;
+
+        /// Collapse whitespace and merge adjacent text (parse_options::collapse_whitespace)
+        bool collapse_whitespace = false;
+
+        /// Number of open elements whose text is kept as written while collapsing
+        size_t preformatted_depth = 0;
+
+        /// Report malformed markup through `error` and stop() instead of throwing
+        bool recover = false;
+
+        /// How to continue after an unmatched closing tag while recovering
+        recovery_mode recovery = recovery_mode::auto_close;
+
+        /// Error behind the last stop() while recovering
+        parse_error error = parse_error::none;
+
+        /// Text seen since the last tag while collapsing: a slice of source or of pending_text
+        std::string_view pending;
+        std::string pending_text;
+
+        /// Spans of the document being expanded by expand_lazy_span(), or nullptr
+        std::shared_ptr<const lazy_document> lazy;
+
+        /// Span of the next element with markup contents, while expanding
+        size_t lazy_span = 0;
+
+        /// Where tokenizing continues after the parse stopped at a lazy element
+        size_t skip_to = std::string_view::npos;
+
+        tree_builder() { set_raw_attributes(true); }
+
+        /// Whether a view lies in the source buffer and may be borrowed
+        bool in_source(std::string_view text) const
+        {
+            std::less<const char *> before;
+            return !source.empty() && !before(text.data(), source.data()) &&
+                   !before(source.data() + source.size(), text.data() + text.size());
+        }
+
+        /// Borrow slices of the source; copy event views that point elsewhere
+        text_ref keep(std::string_view text) const
+        {
+            return in_source(text) ? text_ref::borrow(text) : text_ref(text);
+        }
+
+        void complete(std::shared_ptr<element> node)
+        {
+            if (on_node)
+                on_node(std::move(node));
+            else
+                result.push_back(std::move(node));
+        }
+
+        /// Whether nodes at a depth are handed over rather than attached to a parent
+        bool emits_at(size_t depth) const
+        {
+            return depth == 0 || (on_node && depth == emit_depth);
+        }
+
+        void attach(std::shared_ptr<element> node)
+        {
+            if (emits_at(open.size()))
+                complete(std::move(node));
+            else
+                open.back().node->add_child(std::move(node));
+        }
+
+        void on_text(std::string_view text) override
+        {
+            if (collapse_whitespace)
+            {
+                // Buffered until the next tag, so runs split by comments or empty tags become one node
+                if (pending.empty() && in_source(text) && (preformatted_depth > 0 || !has_whitespace_run(text)))
+                {
+                    pending = text;
+                    return;
+                }
+                if (pending.data() != pending_text.data())
+                    pending_text.assign(pending.data(), pending.size());
+                if (preformatted_depth > 0)
+                    pending_text.append(text.data(), text.size());
+                else
+                    append_collapsed(text, pending_text);
+                pending = pending_text;
+                return;
+            }
+
+            // Whitespace-only runs between tags are dropped
+            if (text.find_first_not_of(" \t\n\r") != std::string_view::npos)
+                attach(make_node<element>(arena, atom(), keep(text), attribute_list()));
+        }
+
+        /**
+         * @brief Attach the text buffered by on_text() while collapsing whitespace.
+         *
+         * Outside preformatted elements the text has already been collapsed,
+         * and is dropped if nothing but a space is left.
+         */
+        void flush_text()
+        {
+            if (pending.empty())
+                return;
+            std::string_view text = pending;
+            pending = std::string_view();
+
+            bool blank = preformatted_depth == 0 && text.find_first_not_of(" \t\n\r\f") == std::string_view::npos;
+            if (!blank && text.data() == pending_text.data())
+                attach(make_node<element>(arena, atom(), text_ref(std::move(pending_text)), attribute_list()));
+            else if (!blank)
+                attach(make_node<element>(arena, atom(), text_ref::borrow(text), attribute_list()));
+            pending_text.clear();
+        }
+
+        void on_doctype(std::string_view declaration) override
+        {
+            // A lazy document's DOCTYPE is found by its first pass
+            if (doctype || lazy)
+                return;
+            doctype = make_node<doctype_element>(arena, std::string(declaration));
+            if (on_node)
+                on_node(doctype);
+        }
+
+        void on_close(std::string_view tag) override
+        {
+            flush_text();
+            if (open.empty())
+            {
+                // A stray closing tag ends the document, unless recovery ignores it
+                if (recover)
+                    error = parse_error::unmatched_close_tag;
+                stop();
+                return;
+            }
+
+            if (!tag.empty() && !closes(open.back().tag, closing_id(tag), tag))
+            {
+                if (!recover)
+                    throw std::runtime_error("Unmatched closing tag: expected </" + open.back().tag.str() + "> but found </" + std::string(tag) + ">");
+                error = parse_error::unmatched_close_tag;
+                stop();
+                if (recovery == recovery_mode::auto_close)
+                    close_through(tag);
+                return;
+            }
+            close_innermost();
+        }
+
+        void close_innermost()
+        {
+            if (collapse_whitespace && is_preformatted_atom(open.back().tag))
+                preformatted_depth--;
+            open.pop_back();
+            if (open.empty())
+                complete(std::move(root));
+            else if (streamed && open.size() == emit_depth)
+                complete(std::move(streamed));
+        }
+
+        /// Close the innermost open element with a tag and everything inside it
+        void close_through(std::string_view tag)
+        {
+            std::uint32_t id = closing_id(tag);
+            for (size_t i = open.size(); i-- > 0;)
+            {
+                if (!closes(open[i].tag, id, tag))
+                    continue;
+                while (open.size() > i)
+                    close_innermost();
+                return;
+            }
+        }
+
+        /**
+         * @brief Allocate the node for an opening tag.
+         * @param tag Interned tag name
+         * @param attribute_text Attribute text of the tag
+         * @param args Constructor arguments following the attribute list
+         */
+        template <typename T, typename... Args>
+        std::shared_ptr<T> open_node(atom tag, std::string_view attribute_text, Args &&...args)
+        {
+            if (attribute_list::is_canonical_text(attribute_text))
+            {
+                auto node = make_node<T>(arena, tag, attribute_list(), std::forward<Args>(args)...);
+                if (!attribute_text.empty())
+                    node->set_attribute_text(keep(attribute_text));
+                return node;
+            }
+            attribute_list attributes;
+            parse_attribute_slices(attribute_text, in_source(attribute_text), attributes);
+            return make_node<T>(arena, tag, std::move(attributes), std::forward<Args>(args)...);
+        }
+
+        void on_open_raw(std::string_view tag, std::string_view attribute_text) override
+        {
+            flush_text();
+            atom tag_atom(tag);
+
+            if (is_self_closing_atom(tag_atom))
+            {
+                attach(open_node<self_closing_element>(tag_atom, attribute_text));
+                return;
+            }
+
+            if (lazy && !html_tokenizer::is_raw_text_tag(tag))
+            {
+                // The contents are skipped here and parsed when the element is first used
+                const lazy_document::span &span = lazy->spans[lazy_span];
+                attach(open_node<lazy_element>(tag_atom, attribute_text, lazy, lazy_span));
+                skip_to = span.end;
+                lazy_span = span.next;
+                stop();
+                return;
+            }
+
+            auto opening_element = open_node<element>(tag_atom, attribute_text);
+            element *node = opening_element.get();
+            if (open.empty())
+                root = std::move(opening_element);
+            else if (emits_at(open.size()))
+                streamed = std::move(opening_element);
+            else
+                open.back().node->add_child(std::move(opening_element));
+            open.push_back({node, tag_atom});
+            if (collapse_whitespace && is_preformatted_atom(tag_atom))
+                preformatted_depth++;
+        }
+
+        /**
+         * @brief Close every element still open and return the collected nodes.
+         * @return Complete top-level nodes, DOCTYPE first
+         */
+        std::vector<std::shared_ptr<element>> finish()
+        {
+            flush_text();
+            open.clear();
+            preformatted_depth = 0;
+            if (streamed)
+                complete(std::move(streamed));
+            if (root)
+                complete(std::move(root));
+            if (doctype && !on_node)
+                result.insert(result.begin(), doctype);
+            return std::move(result);
+        }
+    };
 
     /**
      * @brief Optimized O(n) HTML parser using single-pass algorithm.
      * @param html The HTML string to parse
      * @param start Starting position in the HTML string
      * @param end Ending position in the HTML string
+     * @param arena Arena to allocate nodes from, or nullptr for the heap
      * @return A pair containing the parsed elements and the position after parsing
      *
-     * Recursive parser that processes HTML in linear time using a single-pass
-     * algorithm. This is the core parsing engine that handles:
+     * Iterative parser driven by html_tokenizer, which reads the input once
+     * and normalizes it on the fly. This is the core parsing engine that
+     * handles:
      *
      * - Text content extraction between tags
      * - Opening and closing tag matching
@@ -328,200 +671,663 @@ namespace hh_html_builder
      * - Error detection for malformed HTML
      *
      * The algorithm works by:
-     * 1. Scanning for the next '<' character
-     * 2. Extracting and analyzing tag content
-     * 3. Determining if it's opening, closing, or self-closing
-     * 4. For opening tags, recursively parsing children until matching closing tag
-     * 5. Building element hierarchy with proper parent-child relationships
+     * 1. Reading the next token (text, opening, closing or doctype)
+     * 2. Turning text runs into text nodes
+     * 3. For opening tags, attaching the element to its parent and pushing
+     *    it on the stack of open elements
+     * 4. For closing tags, checking the tag against the top of the stack
+     *    and popping it
+     * 5. Attaching every other node directly to the innermost open element
      *
-     * Returns both the parsed elements and the final parsing position to enable
-     * efficient continuation of parsing at higher recursion levels.
+     * Returns both the parsed elements and the position of the unmatched
+     * closing tag that ended the range (or end if none did). A DOCTYPE found
+     * in the range is returned first.
      */
-    std::pair<std::vector<std::shared_ptr<element>>, size_t> parse_html_optimized(const std::string &html, size_t start, size_t end)
+    std::pair<std::vector<std::shared_ptr<element>>, size_t> parse_html_optimized(const std::string &html, size_t start, size_t end, const std::shared_ptr<node_arena> &arena)
     {
-        std::vector<std::shared_ptr<element>> result;
-        size_t pos = start;
+        html_tokenizer tokenizer(std::string_view(html).substr(0, end), start);
+        tree_builder builder;
+        builder.arena = arena;
+        attribute_list attributes;
+        size_t stray_offset = end;
+        dispatch_tokens(tokenizer, builder, attributes, stray_offset);
+        return {builder.finish(), stray_offset};
+    }
+
+    /**
+     * @brief Main entry point for parsing HTML strings into element objects.
+     * @param html HTML string to parse
+     * @param arena Arena to allocate nodes from, or nullptr for the heap
+     * @return Vector of parsed element objects including DOCTYPE if present
+     *
+     * High-level HTML parsing function that performs complete document
+     * processing in a single pass of html_tokenizer over the input:
+     *
+     * 1. Comments are skipped and line breaks dropped while tokenizing
+     * 2. Tag names are lowercased for consistent handling
+     * 3. The DOCTYPE declaration is recognized as its own token
+     * 4. Tokens are assembled into the element hierarchy
+     * 5. The DOCTYPE (if present) is placed before the parsed elements
+     *
+     * This function handles complete HTML documents and returns a vector
+     * where the first element may be a DOCTYPE declaration followed by
+     * the document's element structure. A closing tag with no open element
+     * ends the parse.
+     */
+    std::vector<std::shared_ptr<element>> parse_html_string(std::string &html, const std::shared_ptr<node_arena> &arena)
+    {
+        parse_options options;
+        options.arena = arena;
+        return parse_html_string(html, options);
+    }
+
+    /**
+     * @brief Sibling ranges of a document that can be parsed independently.
+     */
+    struct split_plan
+    {
+        /// Offset of the first child element of the split element
+        size_t children_start = 0;
 
-        while (pos < end)
+        /// Offset just past the last closed child element
+        size_t children_end = 0;
+
+        /// Slice boundaries at child element starts: slice i is [cuts[i], cuts[i + 1])
+        std::vector<size_t> cuts;
+    };
+
+    /**
+     * @brief Pre-scan a document for split points between sibling elements.
+     * @param source Complete document
+     * @param pieces Number of slices wanted
+     * @param plan Receives the slices
+     * @return false if the document should be parsed serially
+     *
+     * Runs the tokenizer with the same nesting rules as tree_builder but
+     * builds nothing, recording the byte span of every element in the top
+     * levels. From the root it then descends into whichever child holds
+     * more than half of its parent's bytes (typically html, then body, then
+     * a main wrapper) and cuts the children of the element it stops at into
+     * byte-balanced runs. Each cut is at the '<' of a child element, which
+     * also ends any text before it, so every slice is a sequence of complete
+     * siblings that parses on its own exactly as it would in place.
+     *
+     * The range is cut into at most one slice per parallel_parse_min_bytes,
+     * so a slice never costs more to start and attach than it saves.
+     *
+     * Documents the builder would reject or cut short (mismatched or stray
+     * closing tags, unterminated tags or comments), and those with a DOCTYPE
+     * inside the split range, are left to the serial parser, which reports
+     * them exactly as before.
+     */
+    static bool plan_split(std::string_view source, size_t pieces, split_plan &plan)
+    {
+        struct span
+        {
+            size_t start;
+            size_t end;
+            size_t parent;
+        };
+        struct open_entry
         {
-            // Find next tag opening
-            size_t tag_start = html.find('<', pos);
+            atom tag;
+            size_t span_index;
+        };
+        constexpr size_t none = std::string_view::npos;
+        // Deeper elements are too small to be worth splitting around
+        constexpr size_t max_depth = 8;
 
-            // If no more tags, handle remaining text
-            if (tag_start == std::string::npos || tag_start >= end)
+        std::vector<span> spans;
+        std::vector<open_entry> open;
+        std::vector<size_t> doctypes;
+        html_tokenizer tokenizer(source);
+        tokenizer.set_throw_errors(false);
+        html_token token;
+        while (tokenizer.next(token))
+        {
+            if (token.type == token_type::doctype)
             {
-                if (pos < end)
-                {
-                    std::string text_content = html.substr(pos, end - pos);
-                    if (!text_content.empty() && text_content.find_first_not_of(" \t\n\r") != std::string::npos)
-                    {
-                        auto text_element = std::make_shared<element>("", text_content);
-                        result.push_back(text_element);
-                    }
-                }
-                break;
+                doctypes.push_back(token.offset);
             }
-
-            // Handle text content before the tag
-            if (tag_start > pos)
+            else if (token.type == token_type::open_tag)
             {
-                std::string text_content = html.substr(pos, tag_start - pos);
-                if (!text_content.empty() && text_content.find_first_not_of(" \t\n\r") != std::string::npos)
+                atom tag(token.name);
+                if (is_self_closing_atom(tag))
+                    continue;
+                size_t index = none;
+                if (open.size() < max_depth)
                 {
-                    auto text_element = std::make_shared<element>("", text_content);
-                    result.push_back(text_element);
+                    index = spans.size();
+                    spans.push_back({token.offset, none, open.empty() ? none : open.back().span_index});
                 }
+                open.push_back({tag, index});
             }
-
-            // Find tag closing
-            size_t tag_end = html.find('>', tag_start);
-            if (tag_end == std::string::npos || tag_end >= end)
+            else if (token.type == token_type::close_tag)
             {
-                throw std::runtime_error("Malformed HTML: no closing '>' found");
+                if (open.empty())
+                    return false;
+                if (!token.name.empty() && !closes(open.back().tag, closing_id(token.name), token.name))
+                    return false;
+                if (open.back().span_index != none)
+                    spans[open.back().span_index].end = tokenizer.position();
+                open.pop_back();
             }
+        }
+        if (tokenizer.error() != parse_error::none)
+            return false;
 
-            // Extract tag content
-            std::string tag_content = html.substr(tag_start + 1, tag_end - tag_start - 1);
-
-            // Skip empty tags
-            if (tag_content.empty())
+        size_t container = none;
+        size_t container_size = source.size();
+        for (;;)
+        {
+            size_t dominant = none;
+            for (size_t i = 0; i < spans.size(); i++)
             {
-                pos = tag_end + 1;
-                continue;
+                const span &child = spans[i];
+                if (child.parent == container && child.end != none && child.end - child.start > container_size / 2)
+                    dominant = i;
             }
+            if (dominant == none)
+                break;
+            container = dominant;
+            container_size = spans[dominant].end - spans[dominant].start;
+        }
 
-            // Check if it's a closing tag
-            if (tag_content[0] == '/')
+        std::vector<size_t> starts;
+        for (const span &child : spans)
+        {
+            if (child.parent == container && child.end != none)
             {
-                // This is a closing tag, return to parent level
-                return {result, tag_start};
+                starts.push_back(child.start);
+                plan.children_end = child.end;
             }
+        }
+        if (starts.size() < 2)
+            return false;
+        plan.children_start = starts.front();
 
-            // Parse tag name and attributes
-            auto [tag_name, attributes] = extract_tag_and_attributes(tag_content);
-            tag_name = trim(tag_name);
-            attributes = trim(attributes);
-            auto parsed_attributes = parse_attributes(attributes);
+        for (size_t offset : doctypes)
+        {
+            if (offset >= plan.children_start && offset < plan.children_end)
+                return false;
+        }
 
-            // Handle self-closing tags
-            if (is_self_closing_tag(tag_name))
-            {
-                auto elm = std::make_shared<self_closing_element>(tag_name, parsed_attributes);
-                result.push_back(elm);
-                pos = tag_end + 1;
-                continue;
-            }
+        // Only the split range runs in parallel, and every slice pays for a
+        // thread, an arena and the stitch, so each gets at least the minimum
+        size_t total = plan.children_end - plan.children_start;
+        pieces = std::min(pieces, total / parallel_parse_min_bytes);
+        if (pieces < 2)
+            return false;
 
-            // Handle regular opening tags
-            auto opening_element = std::make_shared<element>(tag_name, parsed_attributes);
+        plan.cuts.clear();
+        plan.cuts.push_back(plan.children_start);
+        for (size_t k = 1; k < pieces; k++)
+        {
+            size_t target = plan.children_start + total / pieces * k;
+            auto cut = std::lower_bound(starts.begin(), starts.end(), target);
+            if (cut != starts.end() && *cut > plan.cuts.back())
+                plan.cuts.push_back(*cut);
+        }
+        plan.cuts.push_back(plan.children_end);
+        return plan.cuts.size() > 2;
+    }
 
-            // Recursively parse children
-            auto [children, closing_pos] = parse_html_optimized(html, tag_end + 1, end);
+    /**
+     * @brief Record an error in a parse result.
+     * @param report Result to update; only the first error's position is kept
+     * @param source Document, used to turn the offset into a line and column
+     * @param error Error found
+     * @param offset Offset of the token where it was found
+     */
+    static void report_error(parse_result &report, std::string_view source, parse_error error, size_t offset)
+    {
+        if (report.error_count++ != 0)
+            return;
+        report.error = error;
+        report.offset = offset;
+        size_t line_start = 0;
+        report.line = 1;
+        for (const char *p = source.data(), *end = source.data() + offset;
+             (p = static_cast<const char *>(std::memchr(p, '\n', end - p))) != nullptr; p++)
+        {
+            report.line++;
+            line_start = p - source.data() + 1;
+        }
+        report.column = offset - line_start + 1;
+    }
 
-            // Add children to the element
-            for (const auto &child : children)
+    std::vector<std::shared_ptr<element>> expand_lazy_span(const std::shared_ptr<const lazy_document> &document, std::size_t span_index)
+    {
+        const lazy_document::span &span = document->spans[span_index];
+        tree_builder builder;
+        builder.arena = document->arena;
+        builder.source = document->source;
+        builder.collapse_whitespace = document->collapse_whitespace;
+        builder.preformatted_depth = span.preformatted ? 1 : 0;
+        builder.lazy = document;
+        builder.lazy_span = span_index + 1;
+
+        html_tokenizer tokenizer(document->source.substr(0, span.body_end), span.body_start, false, document->collapse_whitespace);
+        attribute_list attributes;
+        size_t stop_offset = 0;
+        // The builder stops at each child element with markup contents, which is skipped
+        while (dispatch_tokens(tokenizer, builder, attributes, stop_offset) && builder.skip_to != std::string_view::npos)
+        {
+            tokenizer.seek(builder.skip_to);
+            builder.skip_to = std::string_view::npos;
+            builder.resume();
+        }
+        return builder.finish();
+    }
+
+    /**
+     * @brief Parse a document whose elements are expanded on first use.
+     * @param source Document text, retained by arena
+     * @param arena Arena that retains source and that nodes are allocated from
+     * @param options Text settings
+     * @return Top-level nodes, DOCTYPE first; elements are lazy_elements
+     *
+     * The first pass runs the tokenizer over the whole document with the
+     * nesting rules of tree_builder but builds nothing: for every element
+     * whose contents are markup (not void or raw-text elements) it records
+     * where the contents start and where the closing tag starts and ends.
+     * Malformed markup is found in this pass and thrown with the messages
+     * of an eager parse, so expanding an element later cannot fail. Only
+     * the top level is then built, by expand_lazy_span().
+     */
+    static std::vector<std::shared_ptr<element>> parse_lazy(std::string_view source, std::shared_ptr<node_arena> arena, const parse_options &options)
+    {
+        struct open_entry
+        {
+            atom tag;
+            size_t span_index;
+        };
+        constexpr size_t none = std::string_view::npos;
+
+        auto document = std::make_shared<lazy_document>();
+        document->source = source;
+        document->arena = arena;
+        document->collapse_whitespace = options.collapse_whitespace;
+        std::vector<lazy_document::span> &spans = document->spans;
+        spans.push_back({0, none, none, none, false});
+
+        std::vector<open_entry> open;
+        size_t preformatted_depth = 0;
+        size_t document_end = source.size();
+        std::shared_ptr<element> doctype;
+
+        html_tokenizer tokenizer(source, 0, false, options.collapse_whitespace);
+        html_token token;
+        while (tokenizer.next(token))
+        {
+            if (token.type == token_type::doctype)
             {
-                opening_element->add_child(child);
+                if (!doctype)
+                    doctype = make_node<doctype_element>(arena, std::string(token.content));
             }
+            else if (token.type == token_type::open_tag)
+            {
+                atom tag(token.name);
+                if (is_self_closing_atom(tag))
+                    continue;
+                size_t index = none;
+                if (!html_tokenizer::is_raw_text_tag(token.name))
+                {
+                    index = spans.size();
+                    spans.push_back({tokenizer.position(), none, none, none, options.collapse_whitespace && (preformatted_depth > 0 || is_preformatted_atom(tag))});
+                }
+                if (is_preformatted_atom(tag))
+                    preformatted_depth++;
+                open.push_back({tag, index});
+            }
+            else if (token.type == token_type::close_tag)
+            {
+                // A stray closing tag ends the document
+                if (open.empty())
+                {
+                    document_end = token.offset;
+                    break;
+                }
+                if (!token.name.empty() && !closes(open.back().tag, closing_id(token.name), token.name))
+                    throw std::runtime_error("Unmatched closing tag: expected </" + open.back().tag.str() + "> but found </" + std::string(token.name) + ">");
+                if (open.back().span_index != none)
+                {
+                    lazy_document::span &span = spans[open.back().span_index];
+                    span.body_end = token.offset;
+                    span.end = tokenizer.position();
+                    span.next = spans.size();
+                }
+                if (is_preformatted_atom(open.back().tag))
+                    preformatted_depth--;
+                open.pop_back();
+            }
+        }
+
+        // Elements never closed (and the document itself) run to the end
+        for (auto &span : spans)
+        {
+            if (span.end == none)
+                span = {span.body_start, document_end, document_end, spans.size(), span.preformatted};
+        }
 
-            result.push_back(opening_element);
+        std::vector<std::shared_ptr<element>> nodes = expand_lazy_span(document, 0);
+        if (doctype)
+            nodes.insert(nodes.begin(), std::move(doctype));
+        return nodes;
+    }
 
-            // Find the actual closing tag position
-            if (closing_pos < end)
+    /**
+     * @brief Build the element tree for a complete document.
+     * @param source Document text
+     * @param arena Arena to allocate nodes from, or nullptr for the heap
+     * @param options Thread count, text and recovery settings; with
+     *                zero_copy, nodes borrow slices of source (which the
+     *                arena retains)
+     * @param report Receives errors instead of throwing, or nullptr to throw
+     * @return Top-level nodes, DOCTYPE first
+     *
+     * Lazy parses (which require source to be retained by the arena) are
+     * left to parse_lazy().
+     *
+     * With several threads, documents of at least parallel_parse_min_bytes
+     * are split by plan_split(). The main builder parses the part of the
+     * document before the split element's children first, so the slices
+     * know whether they are inside a preformatted element. Each slice is
+     * then parsed by its own tree_builder (with its own arena, as arenas
+     * are single-threaded), while this thread parses the first slice. The
+     * main builder attaches the slices' nodes to the split element in order
+     * and parses the rest, so the tree is the same as a serial parse.
+     * Documents with errors are never split, so the slices cannot fail.
+     */
+    static std::vector<std::shared_ptr<element>> parse_source(std::string_view source, std::shared_ptr<node_arena> arena, const parse_options &options, parse_result *report = nullptr)
+    {
+        if (options.lazy && !report)
+            return parse_lazy(source, std::move(arena), options);
+
+        const bool borrow = options.zero_copy;
+        const bool keep_line_breaks = options.collapse_whitespace;
+        tree_builder builder;
+        builder.arena = arena;
+        builder.collapse_whitespace = options.collapse_whitespace;
+        if (borrow)
+            builder.source = source;
+        attribute_list attributes;
+        size_t stray_offset = 0;
+
+        size_t threads = options.threads;
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        split_plan plan;
+        if (threads < 2 || source.size() < 2 * parallel_parse_min_bytes || !plan_split(source, threads, plan))
+        {
+            html_tokenizer tokenizer(source, 0, false, keep_line_breaks);
+            if (report)
+            {
+                tokenizer.set_throw_errors(false);
+                builder.recover = true;
+                builder.recovery = options.recovery;
+            }
+            if (!report)
             {
-                size_t closing_tag_end = html.find('>', closing_pos);
-                if (closing_tag_end == std::string::npos)
+                dispatch_tokens(tokenizer, builder, attributes, stray_offset);
+                return builder.finish();
+            }
+            for (;;)
+            {
+                if (dispatch_tokens(tokenizer, builder, attributes, stray_offset))
                 {
-                    throw std::runtime_error("Malformed HTML: no closing '>' found for closing tag");
+                    report_error(*report, source, builder.error, stray_offset);
+                    if (options.recovery == recovery_mode::truncate)
+                        break;
+                    builder.error = parse_error::none;
+                    builder.resume();
                 }
-
-                // Verify this is the correct closing tag
-                std::string closing_tag_content = html.substr(closing_pos + 1, closing_tag_end - closing_pos - 1);
-                if (closing_tag_content.length() > 1 && closing_tag_content[0] == '/')
+                else if (tokenizer.error() != parse_error::none)
                 {
-                    std::string closing_tag_name = closing_tag_content.substr(1);
-                    closing_tag_name = trim(closing_tag_name);
-
-                    if (closing_tag_name != tag_name)
-                    {
-                        throw std::runtime_error("Unmatched closing tag: expected </" + tag_name + "> but found </" + closing_tag_name + ">");
-                    }
+                    report_error(*report, source, tokenizer.error(), tokenizer.error_offset());
+                    // Only a tag that lost its '>' leaves input to continue with
+                    if (options.recovery == recovery_mode::truncate || tokenizer.position() >= source.size())
+                        break;
+                    tokenizer.clear_error();
                 }
+                else
+                {
+                    break;
+                }
+            }
+            return builder.finish();
+        }
+
+        html_tokenizer prefix(source.substr(0, plan.children_start), 0, false, keep_line_breaks);
+        dispatch_tokens(prefix, builder, attributes, stray_offset);
+        builder.flush_text();
 
-                pos = closing_tag_end + 1;
+        size_t slices = plan.cuts.size() - 1;
+        std::vector<std::vector<std::shared_ptr<element>>> parts(slices);
+        std::vector<std::exception_ptr> errors(slices);
+        auto parse_slice = [&](size_t i)
+        {
+            try
+            {
+                tree_builder slice_builder;
+                if (arena)
+                {
+                    slice_builder.arena = node_arena::create();
+                    // Borrowed text lives in the buffer retained by the caller's arena
+                    if (borrow)
+                        slice_builder.arena->keep_alive(arena);
+                }
+                if (borrow)
+                    slice_builder.source = source;
+                slice_builder.collapse_whitespace = builder.collapse_whitespace;
+                slice_builder.preformatted_depth = builder.preformatted_depth;
+                html_tokenizer tokenizer(source.substr(0, plan.cuts[i + 1]), plan.cuts[i], false, keep_line_breaks);
+                attribute_list slice_attributes;
+                size_t slice_stray = 0;
+                dispatch_tokens(tokenizer, slice_builder, slice_attributes, slice_stray);
+                parts[i] = slice_builder.finish();
             }
-            else
+            catch (...)
             {
-                // No closing tag found, treat as self-closing or end of input
-                pos = end;
+                errors[i] = std::current_exception();
             }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(slices - 1);
+        for (size_t i = 1; i < slices; i++)
+            workers.emplace_back(parse_slice, i);
+        parse_slice(0);
+        for (auto &worker : workers)
+            worker.join();
+        for (auto &error : errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        for (auto &part : parts)
+        {
+            for (auto &node : part)
+                builder.attach(std::move(node));
         }
+        html_tokenizer suffix(source, plan.children_end, false, keep_line_breaks);
+        dispatch_tokens(suffix, builder, attributes, stray_offset);
+        return builder.finish();
+    }
+
+    std::vector<std::shared_ptr<element>> parse_html_string(std::string &html, const parse_options &options)
+    {
+        std::shared_ptr<node_arena> arena = options.arena;
+        if (!options.zero_copy && !options.lazy)
+            return parse_source(html, std::move(arena), options);
+
+        if (!arena)
+            arena = node_arena::create();
+        // The arena owns the buffer; every node keeps the arena alive
+        std::string_view source = arena->retain(std::move(html));
+        html.clear();
+        return parse_source(source, std::move(arena), options);
+    }
+
+    std::vector<std::shared_ptr<element>> parse_html(std::string_view html, const parse_options &options)
+    {
+        std::shared_ptr<node_arena> arena = options.arena;
+        if (!options.zero_copy && !options.lazy)
+            return parse_source(html, std::move(arena), options);
 
-        return {result, end};
+        if (!arena)
+            arena = node_arena::create();
+        // The caller's buffer may not outlive the nodes; borrow from a copy owned by the arena
+        std::string_view source = arena->retain(std::string(html));
+        return parse_source(source, std::move(arena), options);
     }
 
     /**
-     * @brief Main entry point for parsing HTML strings into element objects.
-     * @param html HTML string to parse (modified during processing)
-     * @return Vector of parsed element objects including DOCTYPE if present
-     *
-     * High-level HTML parsing function that performs complete document processing:
-     *
-     * Preprocessing steps:
-     * 1. Remove HTML comments to avoid parsing interference
-     * 2. Normalize tag names to lowercase for consistent handling
-     * 3. Remove line breaks for simplified parsing
-     * 4. Extract and handle DOCTYPE declaration separately
-     *
-     * Main parsing:
-     * 5. Parse the remaining HTML content into element hierarchy
-     * 6. Combine DOCTYPE (if present) with parsed elements
-     *
-     * This function handles complete HTML documents and returns a vector
-     * where the first element may be a DOCTYPE declaration followed by
-     * the document's element structure.
+     * @brief Result of a parse that failed without reaching the input's errors.
+     * @param error Why it failed
+     * @return Result with no nodes and the error as its only one
      */
-    std::vector<std::shared_ptr<element>> parse_html_string(std::string &html)
+    static parse_result failed_parse(parse_error error) noexcept
     {
+        parse_result result;
+        result.error = error;
+        result.error_count = 1;
+        return result;
+    }
 
-        remove_all_comments(html);
-        transform_tags_to_lower_case(html);
-        remove_all_line_breaks(html);
-        std::string doctype;
-        if (has_doctype(html))
+    parse_result try_parse_html(std::string_view html, const parse_options &options) noexcept
+    {
+        parse_result result;
+        try
         {
-            doctype = extract_doctype(html);
+            std::shared_ptr<node_arena> arena = options.arena;
+            std::string_view source = html;
+            if (options.zero_copy)
+            {
+                if (!arena)
+                    arena = node_arena::create();
+                source = arena->retain(std::string(html));
+            }
+            result.nodes = parse_source(source, std::move(arena), options, &result);
         }
-        std::vector<std::shared_ptr<element>> result;
+        catch (const std::bad_alloc &)
+        {
+            result = failed_parse(parse_error::out_of_resources);
+        }
+        catch (const std::system_error &)
+        {
+            // std::thread could not start a worker for a parallel parse
+            result = failed_parse(parse_error::out_of_resources);
+        }
+        catch (...)
+        {
+            // Malformed input is reported, not thrown, so anything else is a bug
+            result = failed_parse(parse_error::internal_error);
+        }
+        return result;
+    }
 
-        if (!doctype.empty())
+    std::vector<std::shared_ptr<element>> parse_html_file(const std::string &path, const parse_options &options)
+    {
+        mapped_file file(path);
+        std::shared_ptr<node_arena> arena = options.arena;
+        if (!options.zero_copy && !options.lazy)
+            return parse_source(file.view(), std::move(arena), options);
+
+        if (!arena)
+            arena = node_arena::create();
+        // The arena owns the mapping; every node keeps the arena alive
+        std::string_view source = arena->retain(std::move(file));
+        return parse_source(source, std::move(arena), options);
+    }
+
+    push_parser::push_parser(const std::shared_ptr<node_arena> &arena, node_callback on_node, std::size_t emit_depth)
+        : builder(std::make_unique<tree_builder>())
+    {
+        builder->arena = arena;
+        builder->on_node = std::move(on_node);
+        builder->emit_depth = emit_depth;
+    }
+
+    push_parser::~push_parser() = default;
+    push_parser::push_parser(push_parser &&) noexcept = default;
+    push_parser &push_parser::operator=(push_parser &&) noexcept = default;
+
+    /**
+     * @brief Tokenize the buffered input and drop the consumed prefix.
+     * @param partial More input may follow
+     *
+     * Tokens are consumed up to the first one that may continue past the
+     * buffer; its bytes stay buffered and are tokenized again once more
+     * input arrives. The text of a raw-text element stays buffered until
+     * its closing tag arrives, but is searched for that tag only once.
+     */
+    void push_parser::drain(bool partial)
+    {
+        html_tokenizer tokenizer(pending, 0, partial);
+        if (!raw_text_tag.empty())
+            tokenizer.resume_raw_text(raw_text_tag, raw_text_searched);
+        size_t stray_offset = 0;
+        if (dispatch_tokens(tokenizer, *builder, attributes, stray_offset))
         {
-            doctype.pop_back();
-            doctype.erase(doctype.begin(), doctype.begin() + 9); // Remove "<!doctype "
-            std::shared_ptr<element> doctype_element_ptr = std::make_shared<doctype_element>(doctype);
-            result.insert(result.begin(), doctype_element_ptr);
+            // As in parse_html_string, a stray closing tag ends the document
+            stopped = true;
+            pending.clear();
+            return;
         }
+        size_t consumed = tokenizer.position();
+        raw_text_tag = tokenizer.pending_raw_text();
+        raw_text_searched = raw_text_tag.empty() ? 0 : tokenizer.raw_text_searched() - consumed;
+        pending.erase(0, consumed);
+    }
 
-        auto solved = solve_recursive(html);
+    void push_parser::feed(std::string_view chunk)
+    {
+        if (finished)
+            throw std::runtime_error("push_parser: feed() called after finish()");
+        if (stopped || chunk.empty())
+            return;
 
-        result.insert(result.end(), solved.begin(), solved.end());
+        // A buffered incomplete token can only be finished by a '<' or '>'
+        bool can_progress = pending.empty() ||
+                            std::memchr(chunk.data(), '<', chunk.size()) != nullptr ||
+                            std::memchr(chunk.data(), '>', chunk.size()) != nullptr;
+        pending.append(chunk.data(), chunk.size());
+        if (can_progress)
+            drain(true);
+    }
 
-        return result;
+    std::vector<std::shared_ptr<element>> push_parser::finish()
+    {
+        if (finished)
+            throw std::runtime_error("push_parser: finish() called twice");
+        finished = true;
+        if (!stopped)
+            drain(false);
+        pending.clear();
+        pending.shrink_to_fit();
+        return builder->finish();
     }
 
     /**
      * @brief Template-based HTML generation with parameter substitution.
      * @param text HTML template string containing parameter placeholders
      * @param params Map of parameter names to replacement values
+     * @param escape_values HTML-escape substituted values for where they land
      * @return Processed HTML string with parameters substituted
      *
      * Simple but effective templating system that replaces placeholders in the
      * format {{param_name}} with actual values from the parameter map.
      *
      * Process:
-     * 1. Scan the template for {{parameter_name}} patterns
-     * 2. Replace each pattern with the corresponding value from params map
-     * 3. Continue until all placeholders are processed
+     * 1. Index the params map once into a hashed param_table
+     * 2. Scan the template a single time, jumping between {{ occurrences
+     * 3. Append the literal runs and the looked-up values to the result
+     *
+     * The cost is O(text length + number of params) regardless of how many
+     * parameters the map holds, and the result is built append-only into an
+     * exactly-sized buffer.
      *
      * Use cases:
      * - Dynamic content injection into HTML templates
@@ -531,22 +1337,16 @@ namespace hh_html_builder
      *
      * Example: "Hello {{name}}!" with params{"name": "World"} → "Hello World!"
      */
-    std::string parse_html_with_params(const std::string &text, const std::map<std::string, std::string> &params)
+    std::string parse_html_with_params(const std::string &text, const std::map<std::string, std::string> &params, bool escape_values)
     {
-        std::string result = text;
+        param_table table(params, escape_values);
+        counting_sink counter;
+        write_markup_with_params(counter, text, table);
 
-        // Simple parameter substitution: {{param_name}}
-
-        for (const auto &param : params)
-        {
-            std::string placeholder = "{{" + param.first + "}}";
-            size_t pos = 0;
-            while ((pos = result.find(placeholder, pos)) != std::string::npos)
-            {
-                result.replace(pos, placeholder.length(), param.second);
-                pos += param.second.length();
-            }
-        }
+        std::string result;
+        result.reserve(counter.size());
+        string_sink sink(result);
+        write_markup_with_params(sink, text, table);
         return result;
     }
 }
\ No newline at end of file
@@ -1,27 +1,116 @@
 #include <stdexcept>
 #include <iostream>
+#include <mutex>
 
 #include "../includes/document_parser.hpp"
 #include "../includes/element.hpp"
 
 namespace hh_html_builder
 {
-    element::element() : tag("") {}
+    /**
+     * @brief Replace `{{name}}` placeholders inside a string.
+     * @param text String to update
+     * @param params Parameter index used to resolve placeholder names
+     * @param context Where the string is rendered, used when params escapes values
+     *
+     * Strings without any placeholder are left untouched; otherwise the
+     * result is built append-only into an exactly-sized buffer and swapped in.
+     */
+    static void substitute_in_place(text_ref &text, const param_table &params, escape_context context)
+    {
+        if (text.view().find("{{") == std::string_view::npos)
+            return;
+
+        std::string result;
+        result.reserve(substituted_size(text, params, context));
+        string_sink sink(result);
+        write_with_params(sink, text, params, context);
+        text = std::move(result);
+    }
+
+    element::element() {}
 
     element::element(const std::string &tag) : tag(tag) {}
 
     element::element(const std::string &tag, const std::string &text_content)
         : tag(tag), text_content(text_content) {}
 
-    element::element(const std::string &tag, const std::map<std::string, std::string> &attributes)
+    element::element(const std::string &tag, const attribute_list &attributes)
         : tag(tag), attributes(attributes) {}
 
-    element::element(const std::string &tag, const std::string &text_content, const std::map<std::string, std::string> &attributes)
+    element::element(const std::string &tag, const std::string &text_content, const attribute_list &attributes)
         : tag(tag), text_content(text_content), attributes(attributes) {}
 
+    element::element(atom tag, attribute_list attributes)
+        : tag(tag), attributes(std::move(attributes)) {}
+
+    element::element(atom tag, text_ref text_content, attribute_list attributes)
+        : tag(tag), text_content(std::move(text_content)), attributes(std::move(attributes)) {}
+
+    /// Held while attribute text is split by get_attributes(); splits are rare and short
+    static std::mutex attribute_split_mutex;
+
+    // A split of the attribute text is not copied: reading it could race
+    // with get_attributes() on the source, and the copy splits its own text
+    element::element(const element &other)
+        : tag(other.tag), text_content(other.text_content),
+          attributes(other.attribute_text.empty() ? other.attributes : attribute_list()),
+          attribute_text(other.attribute_text), children(other.children) {}
+
+    element::element(element &&other)
+        : tag(std::move(other.tag)), text_content(std::move(other.text_content)),
+          attributes(std::move(other.attributes)), attribute_text(std::move(other.attribute_text)),
+          attributes_split(other.attributes_split.load(std::memory_order_relaxed)), children(std::move(other.children)) {}
+
+    element &element::operator=(const element &other)
+    {
+        if (this != &other)
+        {
+            tag = other.tag;
+            text_content = other.text_content;
+            attributes = other.attribute_text.empty() ? other.attributes : attribute_list();
+            attribute_text = other.attribute_text;
+            attributes_split.store(false, std::memory_order_relaxed);
+            children = other.children;
+        }
+        return *this;
+    }
+
+    element &element::operator=(element &&other)
+    {
+        if (this != &other)
+        {
+            tag = std::move(other.tag);
+            text_content = std::move(other.text_content);
+            attributes = std::move(other.attributes);
+            attribute_text = std::move(other.attribute_text);
+            attributes_split.store(other.attributes_split.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            children = std::move(other.children);
+        }
+        return *this;
+    }
+
+    element::~element()
+    {
+        std::vector<std::shared_ptr<element>> pending = std::move(children);
+        while (!pending.empty())
+        {
+            std::shared_ptr<element> node = std::move(pending.back());
+            pending.pop_back();
+            // Take over the children of nodes about to die so they are freed here, not recursively
+            if (node.use_count() == 1)
+            {
+                for (auto &child : node->children)
+                    pending.push_back(std::move(child));
+                node->children.clear();
+            }
+        }
+    }
+
     void element::add_child(std::shared_ptr<element> child)
     {
-        children.push_back(child);
+        materialize();
+        children.push_back(std::move(child));
     }
 
     void element::set_text_content(const std::string &text_content)
@@ -30,85 +119,299 @@ namespace hh_html_builder
     }
 
     std::string element::get_tag() const
+    {
+        return tag.str();
+    }
+
+    atom element::get_tag_atom() const
     {
         return tag;
     }
 
     std::string element::get_text_content() const
     {
-        return text_content;
+        return text_content.str();
     }
 
-    std::map<std::string, std::string> element::get_attributes() const
+    const attribute_list &element::get_attributes() const
     {
+        if (attribute_text.empty() || attributes_split.load(std::memory_order_acquire))
+            return attributes;
+        std::lock_guard<std::mutex> lock(attribute_split_mutex);
+        // Another thread may have split the text while we waited
+        if (!attributes_split.load(std::memory_order_relaxed))
+        {
+            // The list is a cache of the text, which is still what gets rendered
+            const_cast<element *>(this)->attributes = attribute_list::from_canonical_text(attribute_text, attribute_text.is_borrowed());
+            attributes_split.store(true, std::memory_order_release);
+        }
         return attributes;
     }
 
     std::string element::get_attribute(const std::string &key) const
     {
+        if (!attribute_text.empty())
+        {
+            std::string_view name, value;
+            for (std::size_t pos = 0; attribute_list::next_canonical(attribute_text, pos, name, value);)
+            {
+                if (name == key)
+                    return std::string(value);
+            }
+            return "";
+        }
+
         auto it = attributes.find(key);
         if (it != attributes.end())
         {
-            return it->second;
+            return it->second.str();
         }
         return "";
     }
 
+    void element::set_attribute_text(text_ref text)
+    {
+        attributes.clear();
+        attribute_text = std::move(text);
+        attributes_split.store(false, std::memory_order_relaxed);
+    }
+
+    void element::parse_attribute_text()
+    {
+        if (attribute_text.empty())
+            return;
+        if (!attributes_split.load(std::memory_order_relaxed))
+            attributes = attribute_list::from_canonical_text(attribute_text, attribute_text.is_borrowed());
+        attribute_text = text_ref();
+        attributes_split.store(false, std::memory_order_relaxed);
+    }
+
     std::vector<std::shared_ptr<element>> element::get_children() const
     {
+        materialize();
         return children;
     }
 
-    std::string element::to_string() const
+    void element::write_text(output_sink &sink, std::string_view text, const param_table *params)
     {
-        std::string result = tag.empty() ? "" : ("<" + tag);
+        if (params == nullptr)
+            sink.write(text);
+        else
+            write_with_params(sink, text, *params);
+    }
 
-        if (!tag.empty())
-            for (const auto &attr : attributes)
+    /**
+     * @brief Write one attribute as ` name="value"`, or ` name` if the value is empty.
+     */
+    static void write_attribute(output_sink &sink, std::string_view name, std::string_view value, const param_table *params)
+    {
+        sink.put(' ');
+        sink.write(name);
+        if (value.empty())
+            return;
+
+        if (params == nullptr || params->empty())
+        {
+            sink.write("=\"", 2);
+            sink.write(value);
+            sink.put('"');
+            return;
+        }
+
+        // A value made only of empty parameters renders as a bare attribute
+        if (substituted_size(value, *params, escape_context::attribute) != 0)
+        {
+            sink.write("=\"", 2);
+            write_with_params(sink, value, *params, escape_context::attribute);
+            sink.put('"');
+        }
+    }
+
+    void element::write_attributes(output_sink &sink, const param_table *params) const
+    {
+        if (!attribute_text.empty())
+        {
+            // Canonical text is already in rendered form
+            if (params == nullptr || params->empty())
             {
-                if (attr.second.empty())
-                {
-                    result += " " + attr.first;
-                }
-                else
-                {
-                    result += " " + attr.first + "=\"" + attr.second + "\"";
-                }
+                sink.put(' ');
+                sink.write(attribute_text);
+                return;
             }
-        result += (tag.empty() ? "" : ">") + text_content;
-        for (const auto &child : children)
+            std::string_view name, value;
+            for (std::size_t pos = 0; attribute_list::next_canonical(attribute_text, pos, name, value);)
+                write_attribute(sink, name, value, params);
+            return;
+        }
+
+        for (const auto &attr : attributes)
+            write_attribute(sink, attr.first, attr.second, params);
+    }
+
+    bool element::write_open(output_sink &sink, const param_table *params) const
+    {
+        if (!tag.empty())
         {
-            result += child->to_string();
+            sink.put('<');
+            sink.write(tag);
+            write_attributes(sink, params);
+            sink.put('>');
         }
-        result += tag.empty() ? "" : ("</" + tag + ">\n");
+        write_text(sink, text_content, params);
+        return true;
+    }
+
+    void element::write_close(output_sink &sink) const
+    {
+        if (!tag.empty())
+        {
+            sink.write("</", 2);
+            sink.write(tag);
+            sink.write(">\n", 2);
+        }
+    }
+
+    void element::serialize(output_sink &sink, const param_table *params) const
+    {
+        struct frame
+        {
+            const element *node;
+            std::size_t next_child;
+        };
+        materialize();
+        if (!write_open(sink, params))
+            return;
+        std::vector<frame> open{{this, 0}};
+        while (!open.empty())
+        {
+            frame &top = open.back();
+            if (top.next_child == top.node->children.size())
+            {
+                top.node->write_close(sink);
+                open.pop_back();
+                continue;
+            }
+            const element *child = top.node->children[top.next_child++].get();
+            child->materialize();
+            if (child->write_open(sink, params))
+                open.push_back({child, 0});
+        }
+    }
+
+    void element::write_to(output_sink &sink) const
+    {
+        serialize(sink, nullptr);
+    }
+
+    void element::render(const std::map<std::string, std::string> &params, output_sink &sink, bool escape_values) const
+    {
+        param_table table(params, escape_values);
+        serialize(sink, &table);
+    }
+
+    void element::render(const param_table &params, output_sink &sink) const
+    {
+        serialize(sink, &params);
+    }
+
+    std::size_t element::rendered_size() const
+    {
+        counting_sink counter;
+        serialize(counter, nullptr);
+        return counter.size();
+    }
+
+    std::size_t element::rendered_size(const std::map<std::string, std::string> &params, bool escape_values) const
+    {
+        param_table table(params, escape_values);
+        counting_sink counter;
+        serialize(counter, &table);
+        return counter.size();
+    }
+
+    std::string element::to_string() const
+    {
+        std::string result;
+        result.reserve(rendered_size());
+        string_sink sink(result);
+        serialize(sink, nullptr);
         return result;
     }
 
-    void element::set_params_recursive(const std::map<std::string, std::string> &params)
+    std::string element::render(const std::map<std::string, std::string> &params, bool escape_values) const
     {
-        set_params(params);
-        for (const auto &child : children)
+        param_table table(params, escape_values);
+        counting_sink counter;
+        serialize(counter, &table);
+
+        std::string result;
+        result.reserve(counter.size());
+        string_sink sink(result);
+        serialize(sink, &table);
+        return result;
+    }
+
+    void element::set_params_recursive(const std::map<std::string, std::string> &params, bool escape_values)
+    {
+        param_table table(params, escape_values);
+        apply_params_recursive(table);
+    }
+
+    void element::apply_params_recursive(const param_table &params)
+    {
+        std::vector<element *> pending{this};
+        while (!pending.empty())
         {
-            child->set_params_recursive(params);
+            element *node = pending.back();
+            pending.pop_back();
+            node->materialize();
+            node->apply_params(params);
+            for (const auto &child : node->children)
+                pending.push_back(child.get());
         }
     }
-    void element::set_params(const std::map<std::string, std::string> &params)
+
+    void element::set_params(const std::map<std::string, std::string> &params, bool escape_values)
+    {
+        param_table table(params, escape_values);
+        apply_params(table);
+    }
+
+    void element::apply_params(const param_table &params)
     {
-        this->text_content = parse_html_with_params(text_content, params);
+        if (params.empty())
+            return;
+        substitute_in_place(this->text_content, params, escape_context::text);
+        // Attribute text without placeholders can stay unparsed
+        if (attribute_text.view().find("{{") != std::string_view::npos)
+            parse_attribute_text();
         // check atrs
         for (auto &attr : attributes)
         {
-            attr.second = parse_html_with_params(attr.second, params);
+            substitute_in_place(attr.second, params, escape_context::attribute);
         }
     }
 
     element element::copy() const
     {
+        materialize();
         element copy = *this;
         copy.children.clear();
-        for (const auto &child : children)
+        // Pairs of an original and its copy whose children are still to be copied
+        std::vector<std::pair<const element *, element *>> pending{{this, &copy}};
+        while (!pending.empty())
         {
-            copy.add_child(std::make_shared<element>(child->copy()));
+            auto [source, target] = pending.back();
+            pending.pop_back();
+            target->children.reserve(source->children.size());
+            for (const auto &child : source->children)
+            {
+                child->materialize();
+                auto child_copy = std::make_shared<element>(*child);
+                child_copy->children.clear();
+                pending.push_back({child.get(), child_copy.get()});
+                target->children.push_back(std::move(child_copy));
+            }
         }
         return copy;
     }
@@ -0,0 +1,188 @@
+#include "../includes/html_escape.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HH_HTML_ESCAPE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace hh_html_builder
+{
+    /**
+     * @brief Byte classification tables for the scalar path.
+     *
+     * An entry is non-zero when the byte must be escaped in the given context.
+     */
+    struct escape_tables
+    {
+        unsigned char text[256] = {};
+        unsigned char attribute[256] = {};
+
+        constexpr escape_tables()
+        {
+            for (unsigned char c : {'&', '<', '>'})
+                text[c] = attribute[c] = 1;
+            attribute[static_cast<unsigned char>('"')] = 1;
+            attribute[static_cast<unsigned char>('\'')] = 1;
+        }
+    };
+
+    static constexpr escape_tables tables{};
+
+    /**
+     * @brief Get the replacement entity for a special character.
+     * @param c Character that needs escaping
+     * @return Entity text
+     */
+    static std::string_view entity_for(char c)
+    {
+        switch (c)
+        {
+        case '&':
+            return "&amp;";
+        case '<':
+            return "&lt;";
+        case '>':
+            return "&gt;";
+        case '"':
+            return "&quot;";
+        default:
+            return "&#39;";
+        }
+    }
+
+    static size_t find_special_scalar(const char *data, size_t size, escape_context context)
+    {
+        const unsigned char *table = context == escape_context::attribute ? tables.attribute : tables.text;
+        size_t i = 0;
+        while (i < size && !table[static_cast<unsigned char>(data[i])])
+            i++;
+        return i;
+    }
+
+#ifdef HH_HTML_ESCAPE_X86
+    static size_t find_special_sse2(const char *data, size_t size, escape_context context)
+    {
+        const __m128i amp = _mm_set1_epi8('&');
+        const __m128i lt = _mm_set1_epi8('<');
+        const __m128i gt = _mm_set1_epi8('>');
+        const __m128i quot = _mm_set1_epi8('"');
+        const __m128i apos = _mm_set1_epi8('\'');
+        const bool attribute = context == escape_context::attribute;
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, amp),
+                                        _mm_or_si128(_mm_cmpeq_epi8(chunk, lt), _mm_cmpeq_epi8(chunk, gt)));
+            if (attribute)
+                hits = _mm_or_si128(hits, _mm_or_si128(_mm_cmpeq_epi8(chunk, quot), _mm_cmpeq_epi8(chunk, apos)));
+            int mask = _mm_movemask_epi8(hits);
+            if (mask != 0)
+                return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+        return i + find_special_scalar(data + i, size - i, context);
+    }
+
+    __attribute__((target("avx2"))) static size_t find_special_avx2(const char *data, size_t size, escape_context context)
+    {
+        const __m256i amp = _mm256_set1_epi8('&');
+        const __m256i lt = _mm256_set1_epi8('<');
+        const __m256i gt = _mm256_set1_epi8('>');
+        const __m256i quot = _mm256_set1_epi8('"');
+        const __m256i apos = _mm256_set1_epi8('\'');
+        const bool attribute = context == escape_context::attribute;
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, amp),
+                                           _mm256_or_si256(_mm256_cmpeq_epi8(chunk, lt), _mm256_cmpeq_epi8(chunk, gt)));
+            if (attribute)
+                hits = _mm256_or_si256(hits, _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quot), _mm256_cmpeq_epi8(chunk, apos)));
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+            if (mask != 0)
+                return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+        return i + find_special_sse2(data + i, size - i, context);
+    }
+#endif
+
+    using find_special_fn = size_t (*)(const char *, size_t, escape_context);
+
+    /**
+     * @brief Pick the widest scan kernel supported by the running CPU.
+     * @return Function returning the offset of the first special character
+     */
+    static find_special_fn select_find_special()
+    {
+#ifdef HH_HTML_ESCAPE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return find_special_avx2;
+        return find_special_sse2;
+#else
+        return find_special_scalar;
+#endif
+    }
+
+    /**
+     * @brief Get the scan kernel for this CPU, picking it on first use.
+     * @return Kernel chosen by select_find_special()
+     *
+     * A function-local static rather than a namespace-scope one, so text
+     * escaped during another translation unit's static initialization does
+     * not find the kernel pointer still unset.
+     */
+    static find_special_fn find_special_kernel()
+    {
+        static const find_special_fn kernel = select_find_special();
+        return kernel;
+    }
+
+    void write_escaped(output_sink &sink, std::string_view text, escape_context context)
+    {
+        const find_special_fn find_special = find_special_kernel();
+        const char *data = text.data();
+        const size_t size = text.size();
+        size_t pos = 0;
+        while (pos < size)
+        {
+            size_t clean = find_special(data + pos, size - pos, context);
+            sink.write(data + pos, clean);
+            pos += clean;
+            if (pos == size)
+                break;
+            sink.write(entity_for(data[pos]));
+            pos++;
+        }
+    }
+
+    std::size_t escaped_size(std::string_view text, escape_context context)
+    {
+        const find_special_fn find_special = find_special_kernel();
+        const char *data = text.data();
+        const size_t size = text.size();
+        size_t total = size;
+        size_t pos = 0;
+        while (pos < size)
+        {
+            pos += find_special(data + pos, size - pos, context);
+            if (pos == size)
+                break;
+            total += entity_for(data[pos]).size() - 1;
+            pos++;
+        }
+        return total;
+    }
+
+    std::string escape_html(std::string_view text, escape_context context)
+    {
+        std::string result;
+        result.reserve(escaped_size(text, context));
+        string_sink sink(result);
+        write_escaped(sink, text, context);
+        return result;
+    }
+}
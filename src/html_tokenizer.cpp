@@ -0,0 +1,390 @@
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+#include "../includes/html_tokenizer.hpp"
+
+namespace hh_html_builder
+{
+    /// ASCII whitespace as HTML defines it: space, tab, line feed, form feed, carriage return
+    static constexpr const char *ascii_whitespace = " \t\n\f\r";
+
+    /**
+     * @brief Remove leading and trailing whitespace from a slice.
+     */
+    static std::string_view trim_slice(std::string_view str)
+    {
+        std::size_t start = str.find_first_not_of(ascii_whitespace);
+        if (start == std::string_view::npos)
+            return std::string_view();
+        std::size_t end = str.find_last_not_of(ascii_whitespace);
+        return str.substr(start, end - start + 1);
+    }
+
+    /**
+     * @brief Case-insensitive check for an ASCII prefix.
+     */
+    static bool starts_with_nocase(std::string_view text, std::string_view prefix)
+    {
+        if (text.size() < prefix.size())
+            return false;
+        for (std::size_t i = 0; i < prefix.size(); i++)
+        {
+            char c = text[i];
+            if (c >= 'A' && c <= 'Z')
+                c = static_cast<char>(c - 'A' + 'a');
+            if (c != prefix[i])
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Find a '<' outside quoted attribute values in a tag's contents.
+     * @return Its offset, or npos
+     */
+    static std::size_t find_inner_tag_start(std::string_view tag_content)
+    {
+        if (std::memchr(tag_content.data(), '<', tag_content.size()) == nullptr)
+            return std::string_view::npos;
+        char quote = 0;
+        for (std::size_t i = 0; i < tag_content.size(); i++)
+        {
+            char c = tag_content[i];
+            if (quote)
+            {
+                if (c == quote)
+                    quote = 0;
+            }
+            else if (c == '"' || c == '\'')
+            {
+                quote = c;
+            }
+            else if (c == '<')
+            {
+                return i;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    bool html_tokenizer::is_raw_text_tag(std::string_view name)
+    {
+        return name == "script" || name == "style" || name == "textarea" || name == "title";
+    }
+
+    html_tokenizer::html_tokenizer(std::string_view input, std::size_t start, bool partial, bool keep_line_breaks)
+        : input(input), pos(start < input.size() ? start : input.size()), partial(partial), keep_line_breaks(keep_line_breaks), scanner(input) {}
+
+    std::string_view html_tokenizer::strip_line_breaks(std::string_view text, std::string &scratch, bool &borrowed)
+    {
+        if (std::memchr(text.data(), '\n', text.size()) == nullptr)
+            return text;
+
+        // Merged text already lives in the scratch buffer; slices are copied into it
+        if (text.data() != scratch.data())
+            scratch.assign(text.data(), text.size());
+        scratch.erase(std::remove(scratch.begin(), scratch.end(), '\n'), scratch.end());
+        borrowed = false;
+        return scratch;
+    }
+
+    std::string_view html_tokenizer::line_breaks_to_spaces(std::string_view text, bool &borrowed)
+    {
+        tag_scratch.assign(text.data(), text.size());
+        std::replace(tag_scratch.begin(), tag_scratch.end(), '\n', ' ');
+        borrowed = false;
+        return tag_scratch;
+    }
+
+    std::string_view html_tokenizer::lowercase_name(std::string_view name)
+    {
+        bool has_upper = false;
+        for (char c : name)
+        {
+            if (c >= 'A' && c <= 'Z')
+            {
+                has_upper = true;
+                break;
+            }
+        }
+        if (!has_upper)
+            return name;
+
+        name_scratch.assign(name.data(), name.size());
+        for (char &c : name_scratch)
+        {
+            if (c >= 'A' && c <= 'Z')
+                c = static_cast<char>(c - 'A' + 'a');
+        }
+        return name_scratch;
+    }
+
+    void html_tokenizer::emit_text(html_token &token, std::size_t text_start, std::size_t text_end, bool merged, bool line_break)
+    {
+        std::string_view text;
+        bool borrowed = !merged;
+        if (merged)
+        {
+            text_scratch.append(input.data() + text_start, text_end - text_start);
+            text = text_scratch;
+        }
+        else
+        {
+            text = input.substr(text_start, text_end - text_start);
+        }
+
+        token.type = token_type::text;
+        token.name = std::string_view();
+        token.content = line_break ? strip_line_breaks(text, text_scratch, borrowed) : text;
+        token.offset = text_start;
+        token.borrowed = borrowed;
+    }
+
+    std::size_t html_tokenizer::find_raw_text_end(std::string_view tag, std::size_t from)
+    {
+        const std::size_t size = input.size();
+        bool ignored = false;
+        for (;;)
+        {
+            std::size_t lt = scanner.find('<', from, ignored);
+            if (lt == std::string_view::npos)
+                return partial ? std::string_view::npos : size;
+
+            // "</tag" followed by whitespace, '/' or '>' (or the end of a complete input)
+            std::size_t name_end = lt + 2 + tag.size();
+            if (name_end >= size && partial)
+                return std::string_view::npos;
+            if (name_end <= size && input[lt + 1] == '/' && starts_with_nocase(input.substr(lt + 2), tag))
+            {
+                if (name_end == size)
+                    return lt;
+                char c = input[name_end];
+                if (c == '>' || c == '/' || c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f')
+                    return lt;
+            }
+            from = lt + 1;
+        }
+    }
+
+    std::size_t html_tokenizer::raw_text_resume_offset() const
+    {
+        // A '<' this close to the end may start a closing tag that is cut off
+        std::size_t undecided = raw_text_tag.size() + 2;
+        std::size_t resume = input.size() > undecided ? input.size() - undecided : 0;
+        return resume > pos ? resume : pos;
+    }
+
+    void html_tokenizer::resume_raw_text(std::string_view tag, std::size_t scanned)
+    {
+        raw_text_tag.assign(tag.data(), tag.size());
+        raw_text_scan = scanned;
+        raw_text_end = std::string_view::npos;
+    }
+
+    bool html_tokenizer::fail(parse_error error, std::size_t offset, const char *message)
+    {
+        if (throw_errors)
+            throw std::runtime_error(message);
+        // Nothing after the broken construct can be markup; end the input at it
+        failure = error;
+        failure_offset = offset;
+        pos = input.size();
+        return false;
+    }
+
+    bool html_tokenizer::next(html_token &token)
+    {
+        const std::size_t size = input.size();
+
+        if (!raw_text_tag.empty())
+        {
+            // The search for the closing tag goes on where the last piece of input ended
+            std::size_t end = find_raw_text_end(raw_text_tag, raw_text_scan > pos ? raw_text_scan : pos);
+            if (end == std::string_view::npos)
+            {
+                raw_text_scan = raw_text_resume_offset();
+                return false;
+            }
+            raw_text_tag.clear();
+            raw_text_end = end;
+        }
+
+        if (raw_text_end != std::string_view::npos)
+        {
+            std::size_t text_start = pos;
+            pos = raw_text_end;
+            raw_text_end = std::string_view::npos;
+            if (pos > text_start)
+            {
+                token.type = token_type::text;
+                token.name = std::string_view();
+                token.content = input.substr(text_start, pos - text_start);
+                token.offset = text_start;
+                token.borrowed = true;
+                return true;
+            }
+        }
+
+        // Text is a single slice unless comments split it into pieces
+        const std::size_t token_start = pos;
+        std::size_t text_start = pos;
+        bool merged = false;
+        bool text_line_break = false;
+        text_scratch.clear();
+
+        while (pos < size)
+        {
+            std::size_t lt = scanner.find('<', pos, text_line_break);
+            if (lt == std::string_view::npos)
+            {
+                // Trailing text may continue in the next piece of input
+                if (partial)
+                    break;
+                lt = size;
+            }
+
+            // A cut-off "<!--" could still open a comment that merges the text around it
+            if (partial && size - lt < 4 && std::string_view("<!--").substr(0, size - lt) == input.substr(lt))
+            {
+                pos = token_start;
+                return false;
+            }
+
+            if (lt < size && input.compare(lt, 4, "<!--") == 0)
+            {
+                // The comment ends at the first '>' preceded by "--" past the opener
+                bool ignored = false;
+                std::size_t gt = lt + 4;
+                for (;;)
+                {
+                    gt = scanner.find('>', gt, ignored);
+                    if (gt == std::string_view::npos && partial)
+                    {
+                        pos = token_start;
+                        return false;
+                    }
+                    if (gt == std::string_view::npos && !throw_errors && (lt > text_start || !text_scratch.empty()))
+                    {
+                        // Return the text before the broken comment, then end the input
+                        emit_text(token, text_start, lt, merged, !keep_line_breaks && (text_line_break || merged));
+                        fail(parse_error::unterminated_comment, lt, nullptr);
+                        return true;
+                    }
+                    if (gt == std::string_view::npos)
+                        return fail(parse_error::unterminated_comment, lt, "Malformed comment: no closing tag found");
+                    if (gt >= lt + 6 && input[gt - 1] == '-' && input[gt - 2] == '-')
+                        break;
+                    gt++;
+                }
+                text_scratch.append(input.data() + text_start, lt - text_start);
+                merged = true;
+                pos = gt + 1;
+                text_start = pos;
+                continue;
+            }
+
+            // Pending text is emitted first; the tag is read by the next call
+            if (lt > text_start || !text_scratch.empty())
+            {
+                emit_text(token, text_start, lt, merged, !keep_line_breaks && (text_line_break || merged));
+                pos = lt;
+                return true;
+            }
+
+            if (lt == size)
+                break;
+
+            bool tag_line_break = false;
+            std::size_t gt = scanner.find('>', lt, tag_line_break);
+            if (gt == std::string_view::npos && partial)
+            {
+                pos = token_start;
+                return false;
+            }
+            if (gt == std::string_view::npos)
+                return fail(parse_error::unterminated_tag, lt, "Malformed HTML: no closing '>' found");
+
+            std::string_view tag_content = input.substr(lt + 1, gt - lt - 1);
+            if (!throw_errors)
+            {
+                // The tag lost its '>' and runs into the next one; drop it and resume there
+                std::size_t inner = find_inner_tag_start(tag_content);
+                if (inner != std::string_view::npos)
+                {
+                    failure = parse_error::unterminated_tag;
+                    failure_offset = lt;
+                    pos = lt + 1 + inner;
+                    return false;
+                }
+            }
+            pos = gt + 1;
+            text_start = pos;
+            text_line_break = false;
+
+            // Empty tags are skipped
+            if (tag_content.empty())
+                continue;
+
+            // A line break inside a tag separates like any other whitespace
+            bool borrowed = true;
+            if (tag_line_break)
+                tag_content = line_breaks_to_spaces(tag_content, borrowed);
+            token.offset = lt;
+            token.borrowed = borrowed;
+
+            if (starts_with_nocase(tag_content, "!doctype"))
+            {
+                token.type = token_type::doctype;
+                token.name = std::string_view();
+                token.content = tag_content.substr(8);
+                return true;
+            }
+
+            if (tag_content[0] == '/')
+            {
+                token.type = token_type::close_tag;
+                token.name = lowercase_name(trim_slice(tag_content.substr(1)));
+                token.content = std::string_view();
+                return true;
+            }
+
+            std::size_t space_pos = tag_content.find_first_of(ascii_whitespace);
+            std::string_view name = trim_slice(tag_content.substr(0, space_pos));
+            // `<br/>` names the element "br"
+            if (space_pos == std::string_view::npos && name.size() > 1 && name.back() == '/')
+                name.remove_suffix(1);
+            token.type = token_type::open_tag;
+            token.name = lowercase_name(name);
+            token.content = space_pos == std::string_view::npos ? std::string_view() : tag_content.substr(space_pos + 1);
+
+            if (is_raw_text_tag(token.name))
+            {
+                raw_text_end = find_raw_text_end(token.name, pos);
+                // Without its closing tag the text may continue in the next piece of input
+                if (raw_text_end == std::string_view::npos)
+                {
+                    raw_text_tag.assign(token.name.data(), token.name.size());
+                    raw_text_scan = raw_text_resume_offset();
+                }
+            }
+            return true;
+        }
+
+        if (partial)
+        {
+            // Comments and tags before token_start were consumed; text waits for more input
+            if (text_start < size || !text_scratch.empty())
+                pos = token_start;
+            return false;
+        }
+
+        // Text left over after the last comment
+        if (!text_scratch.empty())
+        {
+            emit_text(token, text_start, text_start, true, !keep_line_breaks);
+            return true;
+        }
+        return false;
+    }
+}
@@ -0,0 +1,20 @@
+#include "../includes/lazy_element.hpp"
+
+namespace hh_html_builder
+{
+    lazy_element::lazy_element(atom tag, attribute_list attributes, std::shared_ptr<const lazy_document> document, std::size_t span_index)
+        : element(tag, std::move(attributes)), document(std::move(document)), span_index(span_index) {}
+
+    void lazy_element::materialize() const
+    {
+        if (expanded.load(std::memory_order_acquire))
+            return;
+        std::lock_guard<std::mutex> lock(document->expand_mutex);
+        // Another thread may have expanded the element while we waited
+        if (expanded.load(std::memory_order_relaxed))
+            return;
+        // Children are a cache of the source; building them does not change the element's value
+        const_cast<lazy_element *>(this)->children = expand_lazy_span(document, span_index);
+        expanded.store(true, std::memory_order_release);
+    }
+}
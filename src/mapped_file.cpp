@@ -0,0 +1,111 @@
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../includes/mapped_file.hpp"
+
+namespace hh_html_builder
+{
+    mapped_file::mapped_file(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error("mapped_file: cannot open " + path + ": " + std::strerror(errno));
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("mapped_file: cannot stat " + path + ": " + std::strerror(error));
+        }
+
+        if (!S_ISREG(info.st_mode))
+        {
+            ::close(fd);
+            throw std::runtime_error("mapped_file: " + path + " is not a regular file");
+        }
+
+        std::size_t length = static_cast<std::size_t>(info.st_size);
+        if (length > 0 && length < mmap_threshold)
+        {
+            buffer.reset(new char[length]);
+            std::size_t done = 0;
+            while (done < length)
+            {
+                ssize_t got = ::read(fd, buffer.get() + done, length - done);
+                if (got < 0 && errno == EINTR)
+                    continue;
+                if (got < 0)
+                {
+                    int error = errno;
+                    ::close(fd);
+                    throw std::runtime_error("mapped_file: cannot read " + path + ": " + std::strerror(error));
+                }
+                // The file shrank since fstat; keep what was read
+                if (got == 0)
+                    break;
+                done += static_cast<std::size_t>(got);
+            }
+            data = buffer.get();
+            size = done;
+        }
+        else if (length > 0)
+        {
+            void *mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                int error = errno;
+                ::close(fd);
+                throw std::runtime_error("mapped_file: cannot map " + path + ": " + std::strerror(error));
+            }
+            // The parser reads front to back; ask for aggressive read-ahead
+            ::madvise(mapping, length, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(mapping);
+            size = length;
+        }
+
+        // The mapping stays valid after the descriptor is closed
+        ::close(fd);
+    }
+
+    void mapped_file::release() noexcept
+    {
+        if (data != nullptr && !buffer)
+            ::munmap(const_cast<char *>(data), size);
+        buffer.reset();
+        data = nullptr;
+        size = 0;
+    }
+
+    mapped_file::~mapped_file()
+    {
+        release();
+    }
+
+    mapped_file::mapped_file(mapped_file &&other) noexcept
+        : data(other.data), size(other.size), buffer(std::move(other.buffer))
+    {
+        other.data = nullptr;
+        other.size = 0;
+    }
+
+    mapped_file &mapped_file::operator=(mapped_file &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            data = other.data;
+            size = other.size;
+            buffer = std::move(other.buffer);
+            other.data = nullptr;
+            other.size = 0;
+        }
+        return *this;
+    }
+}
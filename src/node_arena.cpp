@@ -0,0 +1,89 @@
+#include <stdexcept>
+#include <cstdint>
+
+#include "../includes/node_arena.hpp"
+
+namespace hh_html_builder
+{
+    node_arena::node_arena(std::size_t block_size)
+        : block_size(block_size == 0 ? 64 * 1024 : block_size) {}
+
+    std::shared_ptr<node_arena> node_arena::create(std::size_t block_size)
+    {
+        return std::shared_ptr<node_arena>(new node_arena(block_size));
+    }
+
+    void *node_arena::allocate(std::size_t size, std::size_t alignment)
+    {
+        while (current < blocks.size())
+        {
+            block &blk = blocks[current];
+            auto base = reinterpret_cast<std::uintptr_t>(blk.data.get());
+            std::size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+            if (aligned + size <= blk.size)
+            {
+                offset = aligned + size;
+                live.fetch_add(1, std::memory_order_relaxed);
+                return blk.data.get() + aligned;
+            }
+            // Blocks kept by reset() are reused before new ones are added
+            current++;
+            offset = 0;
+        }
+
+        std::size_t size_needed = size + alignment;
+        std::size_t new_size = size_needed > block_size ? size_needed : block_size;
+        blocks.push_back({std::unique_ptr<char[]>(new char[new_size]), new_size});
+        current = blocks.size() - 1;
+        offset = 0;
+        return allocate(size, alignment);
+    }
+
+    void node_arena::deallocate() noexcept
+    {
+        live.fetch_sub(1, std::memory_order_release);
+    }
+
+    std::string_view node_arena::retain(std::string source)
+    {
+        auto retained = std::make_shared<const std::string>(std::move(source));
+        std::string_view view = *retained;
+        sources.push_back(std::move(retained));
+        return view;
+    }
+
+    std::string_view node_arena::retain(mapped_file source)
+    {
+        auto retained = std::make_shared<const mapped_file>(std::move(source));
+        std::string_view view = retained->view();
+        sources.push_back(std::move(retained));
+        return view;
+    }
+
+    void node_arena::keep_alive(std::shared_ptr<const void> owner)
+    {
+        sources.push_back(std::move(owner));
+    }
+
+    void node_arena::reset()
+    {
+        if (live.load(std::memory_order_acquire) != 0)
+            throw std::runtime_error("node_arena: cannot reset while nodes are still alive");
+        sources.clear();
+        current = 0;
+        offset = 0;
+    }
+
+    std::size_t node_arena::live_allocations() const
+    {
+        return live.load(std::memory_order_relaxed);
+    }
+
+    std::size_t node_arena::capacity() const
+    {
+        std::size_t total = 0;
+        for (const auto &blk : blocks)
+            total += blk.size;
+        return total;
+    }
+}
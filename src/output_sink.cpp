@@ -0,0 +1,68 @@
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "../includes/output_sink.hpp"
+
+namespace hh_html_builder
+{
+    fd_sink::fd_sink(int fd, std::size_t buffer_size)
+        : fd(fd), capacity(buffer_size == 0 ? 1 : buffer_size)
+    {
+        buffer.reserve(capacity);
+    }
+
+    fd_sink::~fd_sink()
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    void fd_sink::write_all(const char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error(std::string("fd_sink: write failed: ") + std::strerror(errno));
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+
+    void fd_sink::write(const char *data, std::size_t size)
+    {
+        if (buffer.size() + size <= capacity)
+        {
+            buffer.append(data, size);
+            return;
+        }
+
+        flush();
+
+        // Large runs bypass the buffer entirely instead of being copied twice
+        if (size >= capacity)
+            write_all(data, size);
+        else
+            buffer.append(data, size);
+    }
+
+    void fd_sink::flush()
+    {
+        if (buffer.empty())
+            return;
+        write_all(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
@@ -0,0 +1,163 @@
+#include <cstring>
+
+#include "../includes/param_table.hpp"
+
+namespace hh_html_builder
+{
+    /**
+     * @brief FNV-1a hash of a parameter name.
+     * @param name Parameter name to hash
+     * @return 64-bit hash value
+     *
+     * Parameter names are short identifiers, for which FNV-1a is both fast
+     * and well distributed.
+     */
+    std::uint64_t param_table::hash_name(std::string_view name)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : name)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    param_table::param_table(const std::map<std::string, std::string> &params, bool escape_values)
+        : count(params.size()), escape(escape_values)
+    {
+        if (params.empty())
+            return;
+
+        // Keep the load factor at or below one half so probe chains stay short
+        std::size_t capacity = 4;
+        while (capacity < params.size() * 2)
+            capacity <<= 1;
+        slots.assign(capacity, slot{0, std::string_view(), nullptr});
+
+        const std::size_t mask = capacity - 1;
+        for (const auto &param : params)
+        {
+            std::uint64_t hash = hash_name(param.first);
+            std::size_t index = static_cast<std::size_t>(hash) & mask;
+            while (slots[index].value != nullptr)
+                index = (index + 1) & mask;
+            slots[index] = slot{hash, param.first, &param.second};
+        }
+    }
+
+    const std::string *param_table::find(std::string_view name) const
+    {
+        if (slots.empty())
+            return nullptr;
+
+        std::uint64_t hash = hash_name(name);
+        const std::size_t mask = slots.size() - 1;
+        std::size_t index = static_cast<std::size_t>(hash) & mask;
+        while (slots[index].value != nullptr)
+        {
+            if (slots[index].hash == hash && slots[index].name == name)
+                return slots[index].value;
+            index = (index + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Substitute placeholders, asking for the escape context of each one.
+     * @param sink Destination that receives the substituted text
+     * @param text Template text to scan
+     * @param params Parameter index used to resolve placeholder names
+     * @param context_at Called with the offset of each substituted placeholder
+     *                   (in increasing order) when params escapes values
+     */
+    template <typename ContextAt>
+    static void substitute(output_sink &sink, std::string_view text, const param_table &params, ContextAt &&context_at)
+    {
+        if (params.empty())
+        {
+            sink.write(text);
+            return;
+        }
+
+        const char *data = text.data();
+        const size_t size = text.size();
+        size_t run_start = 0;
+        size_t pos = 0;
+
+        while (pos + 1 < size)
+        {
+            const void *brace = std::memchr(data + pos, '{', size - pos - 1);
+            if (brace == nullptr)
+                break;
+            pos = static_cast<const char *>(brace) - data;
+            if (data[pos + 1] != '{')
+            {
+                pos++;
+                continue;
+            }
+
+            size_t name_end = text.find("}}", pos + 2);
+            if (name_end == std::string_view::npos)
+                break;
+
+            // The innermost "{{" before the closing braces opens the placeholder
+            size_t open = text.rfind("{{", name_end - 2);
+            std::string_view name = text.substr(open + 2, name_end - open - 2);
+
+            const std::string *value = params.find(name);
+            if (value != nullptr)
+            {
+                sink.write(data + run_start, open - run_start);
+                if (params.escapes_values())
+                    write_escaped(sink, *value, context_at(open));
+                else
+                    sink.write(*value);
+                run_start = name_end + 2;
+            }
+            pos = name_end + 2;
+        }
+
+        sink.write(data + run_start, size - run_start);
+    }
+
+    void write_with_params(output_sink &sink, std::string_view text, const param_table &params,
+                           escape_context context)
+    {
+        substitute(sink, text, params, [context](size_t)
+                   { return context; });
+    }
+
+    std::size_t substituted_size(std::string_view text, const param_table &params,
+                                 escape_context context)
+    {
+        counting_sink counter;
+        write_with_params(counter, text, params, context);
+        return counter.size();
+    }
+
+    void write_markup_with_params(output_sink &sink, std::string_view markup, const param_table &params)
+    {
+        // Whether the scan is inside a tag, and inside which quotes; advanced lazily up to each placeholder
+        bool in_tag = false;
+        char quote = 0;
+        size_t scanned = 0;
+        auto context_at = [&](size_t until)
+        {
+            for (; scanned < until; scanned++)
+            {
+                char c = markup[scanned];
+                if (!in_tag)
+                    in_tag = c == '<';
+                else if (quote != 0)
+                    quote = c == quote ? 0 : quote;
+                else if (c == '"' || c == '\'')
+                    quote = c;
+                else if (c == '>')
+                    in_tag = false;
+            }
+            return in_tag ? escape_context::attribute : escape_context::text;
+        };
+        substitute(sink, markup, params, context_at);
+    }
+}
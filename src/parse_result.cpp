@@ -0,0 +1,24 @@
+#include "../includes/parse_result.hpp"
+
+namespace hh_html_builder
+{
+    const char *describe(parse_error error)
+    {
+        switch (error)
+        {
+        case parse_error::none:
+            return "no error";
+        case parse_error::unterminated_comment:
+            return "Malformed comment: no closing tag found";
+        case parse_error::unterminated_tag:
+            return "Malformed HTML: no closing '>' found";
+        case parse_error::unmatched_close_tag:
+            return "Unmatched closing tag";
+        case parse_error::out_of_resources:
+            return "Out of memory or threads";
+        case parse_error::internal_error:
+            return "Internal parser error";
+        }
+        return "unknown error";
+    }
+}
@@ -5,25 +5,19 @@ namespace hh_html_builder
     self_closing_element::self_closing_element(const std::string &tag)
         : element(tag) {}
 
-    self_closing_element::self_closing_element(const std::string &tag, const std::map<std::string, std::string> &attributes)
+    self_closing_element::self_closing_element(const std::string &tag, const attribute_list &attributes)
         : element(tag, attributes) {}
 
-    std::string self_closing_element::to_string() const
+    self_closing_element::self_closing_element(atom tag, attribute_list attributes)
+        : element(tag, std::move(attributes)) {}
+
+    bool self_closing_element::write_open(output_sink &sink, const param_table *params) const
     {
-        std::string result = "<" + get_tag();
-        for (const auto &attr : get_attributes())
-        {
-            if (attr.second.empty())
-            {
-                result += " " + attr.first;
-            }
-            else
-            {
-                result += " " + attr.first + "=\"" + attr.second + "\"";
-            }
-        }
-        result += " />";
-        return result;
+        sink.put('<');
+        sink.write(tag);
+        write_attributes(sink, params);
+        sink.write(" />", 3);
+        return false;
     }
 
     std::vector<std::shared_ptr<element>> self_closing_element::get_children() const
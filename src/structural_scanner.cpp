@@ -0,0 +1,98 @@
+#include "../includes/structural_scanner.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HH_STRUCTURAL_X86 1
+#include <immintrin.h>
+#endif
+
+namespace hh_html_builder
+{
+    static structural_masks classify_scalar(const unsigned char *block, std::size_t size)
+    {
+        structural_masks masks;
+        for (unsigned i = 0; i < size; i++)
+        {
+            std::uint64_t bit = std::uint64_t(1) << i;
+            if (block[i] == '<')
+                masks.lt |= bit;
+            else if (block[i] == '>')
+                masks.gt |= bit;
+            else if (block[i] == '\n')
+                masks.line_break |= bit;
+        }
+        return masks;
+    }
+
+#ifdef HH_STRUCTURAL_X86
+    static structural_masks classify_sse2(const unsigned char *block)
+    {
+        const __m128i lt = _mm_set1_epi8('<');
+        const __m128i gt = _mm_set1_epi8('>');
+        const __m128i nl = _mm_set1_epi8('\n');
+
+        structural_masks masks;
+        for (unsigned i = 0; i < 64; i += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+            masks.lt |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lt)))) << i;
+            masks.gt |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, gt)))) << i;
+            masks.line_break |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl)))) << i;
+        }
+        return masks;
+    }
+
+    /**
+     * @brief Combine the compare results of two 32-byte halves into one 64-bit mask.
+     */
+    __attribute__((target("avx2"))) static inline std::uint64_t join_masks(__m256i lo_hits, __m256i hi_hits)
+    {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(lo_hits))) |
+               (static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(hi_hits))) << 32);
+    }
+
+    __attribute__((target("avx2"))) static structural_masks classify_avx2(const unsigned char *block)
+    {
+        const __m256i lt = _mm256_set1_epi8('<');
+        const __m256i gt = _mm256_set1_epi8('>');
+        const __m256i nl = _mm256_set1_epi8('\n');
+
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+
+        structural_masks masks;
+        masks.lt = join_masks(_mm256_cmpeq_epi8(lo, lt), _mm256_cmpeq_epi8(hi, lt));
+        masks.gt = join_masks(_mm256_cmpeq_epi8(lo, gt), _mm256_cmpeq_epi8(hi, gt));
+        masks.line_break = join_masks(_mm256_cmpeq_epi8(lo, nl), _mm256_cmpeq_epi8(hi, nl));
+        return masks;
+    }
+
+    using classify_fn = structural_masks (*)(const unsigned char *);
+
+    /**
+     * @brief Pick the widest classifier supported by the running CPU.
+     * @return Function classifying a full 64-byte block
+     */
+    static classify_fn select_classify()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return classify_avx2;
+        return classify_sse2;
+    }
+
+    static const classify_fn classify_full_block = select_classify();
+#endif
+
+    structural_masks classify_block(const char *data, std::size_t size)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+        // The final partial block is too short for a vector load
+        if (size < 64)
+            return classify_scalar(bytes, size);
+#ifdef HH_STRUCTURAL_X86
+        return classify_full_block(bytes);
+#else
+        return classify_scalar(bytes, 64);
+#endif
+    }
+}
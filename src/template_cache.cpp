@@ -0,0 +1,373 @@
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <map>
+#include <algorithm>
+#include <exception>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../includes/template_cache.hpp"
+#include "../includes/node_arena.hpp"
+
+namespace hh_html_builder
+{
+    std::uint64_t content_hash(std::string_view data)
+    {
+        constexpr std::uint64_t k1 = 0x9e3779b97f4a7c15ull;
+        constexpr std::uint64_t k2 = 0xbf58476d1ce4e5b9ull;
+        const char *p = data.data();
+        std::size_t remaining = data.size();
+        std::uint64_t hash = remaining * k1;
+
+        auto mix = [&](std::uint64_t word)
+        {
+            hash ^= word * k2;
+            hash = ((hash << 27) | (hash >> 37)) * k1;
+        };
+        for (; remaining >= 8; p += 8, remaining -= 8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, p, 8);
+            mix(word);
+        }
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, p, remaining);
+        mix(tail);
+
+        // Final avalanche (splitmix64), so nearby inputs give unrelated hashes
+        hash ^= hash >> 30;
+        hash *= k2;
+        hash ^= hash >> 27;
+        hash *= 0x94d049bb133111ebull;
+        hash ^= hash >> 31;
+        return hash;
+    }
+
+    /**
+     * @brief Cache entry for one path.
+     */
+    struct template_cache::slot
+    {
+        /// Held while the template is (re)loaded, so each version is parsed once
+        std::mutex loading;
+
+        /// Current version, or nullptr while the first load runs (guarded by template_cache::mutex)
+        std::shared_ptr<const cached_template> current;
+
+        /// File stamp current was last checked against (guarded by template_cache::mutex)
+        file_stamp stamp;
+
+        /// Error from parsing the version with failed_stamp, or nullptr (guarded by template_cache::mutex)
+        std::exception_ptr failure;
+
+        /// File stamp of the version that failed to parse
+        file_stamp failed_stamp;
+
+        /// Value of template_cache::clock when the template was last used
+        std::atomic<std::uint64_t> last_used{0};
+    };
+
+    static std::int64_t modified_ns(const struct stat &info)
+    {
+#ifdef __APPLE__
+        return static_cast<std::int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+        return static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+    }
+
+    template_cache::template_cache(std::size_t max_bytes, const parse_options &options)
+        : max_bytes(max_bytes), options(options)
+    {
+        // Each version gets its own arena, retaining its source
+        this->options.arena = nullptr;
+        this->options.zero_copy = true;
+        this->options.lazy = false;
+    }
+
+    template_cache::~template_cache() = default;
+
+    template_cache::file_stamp template_cache::stat_file(const std::string &path)
+    {
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0)
+            throw std::runtime_error("template_cache: cannot stat " + path + ": " + std::strerror(errno));
+        return {modified_ns(info), static_cast<std::int64_t>(info.st_size)};
+    }
+
+    std::string template_cache::read_file(const std::string &path, file_stamp &stamp)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error("template_cache: cannot open " + path + ": " + std::strerror(errno));
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            ::close(fd);
+            throw std::runtime_error("template_cache: " + path + " is not a readable regular file");
+        }
+        stamp = {modified_ns(info), static_cast<std::int64_t>(info.st_size)};
+
+        std::string contents(static_cast<std::size_t>(info.st_size), '\0');
+        std::size_t done = 0;
+        while (done < contents.size())
+        {
+            ssize_t got = ::read(fd, &contents[done], contents.size() - done);
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got < 0)
+            {
+                int error = errno;
+                ::close(fd);
+                throw std::runtime_error("template_cache: cannot read " + path + ": " + std::strerror(error));
+            }
+            // The file shrank since fstat; keep what was read
+            if (got == 0)
+                break;
+            done += static_cast<std::size_t>(got);
+        }
+        ::close(fd);
+        contents.resize(done);
+        return contents;
+    }
+
+    void template_cache::touch(slot &entry)
+    {
+        entry.last_used.store(clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Answer a lookup from a slot without reading the file, if possible.
+     * @param entry Slot of the template
+     * @param stamp Current stamp of the file
+     * @param failure Receives the error to throw for a file that failed to parse
+     *                and has not changed since, when there is no version to serve
+     * @return Version to return, or nullptr
+     *
+     * Called with the cache-wide lock held, shared or exclusive.
+     */
+    std::shared_ptr<const cached_template> template_cache::cached_version(slot &entry, const file_stamp &stamp, std::exception_ptr &failure)
+    {
+        bool unchanged = entry.current && entry.stamp == stamp;
+        // A file that failed to parse is not parsed again until it changes; the last good version is served meanwhile
+        bool still_broken = entry.failure && entry.failed_stamp == stamp;
+        if (still_broken && !entry.current)
+            failure = entry.failure;
+        if (!unchanged && !(still_broken && entry.current))
+            return nullptr;
+        touch(entry);
+        hits++;
+        return entry.current;
+    }
+
+    std::shared_ptr<const cached_template> template_cache::get(const std::string &path)
+    {
+        file_stamp stamp = stat_file(path);
+        std::shared_ptr<slot> entry;
+        std::exception_ptr failure;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = slots.find(path);
+            if (it != slots.end())
+            {
+                entry = it->second;
+                if (auto version = cached_version(*entry, stamp, failure))
+                    return version;
+            }
+        }
+        if (failure)
+            std::rethrow_exception(failure);
+
+        if (!entry)
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            std::shared_ptr<slot> &found = slots[path];
+            if (!found)
+                found = std::make_shared<slot>();
+            entry = found;
+        }
+        return load(path, entry);
+    }
+
+    /**
+     * @brief Bring a slot up to date with its file.
+     *
+     * Runs with the slot's loading mutex held but not the cache-wide lock,
+     * which is taken only to read and publish the result, so lookups of
+     * other templates go on while the file is read and parsed.
+     */
+    std::shared_ptr<const cached_template> template_cache::load(const std::string &path, const std::shared_ptr<slot> &entry)
+    {
+        std::lock_guard<std::mutex> loading(entry->loading);
+        try
+        {
+            // Another caller may have loaded this version while we waited
+            file_stamp stamp = stat_file(path);
+            std::exception_ptr failure;
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                if (auto version = cached_version(*entry, stamp, failure))
+                    return version;
+            }
+            if (failure)
+                std::rethrow_exception(failure);
+
+            std::string source = read_file(path, stamp);
+            std::uint64_t hash = content_hash(source);
+            {
+                // Touched or rewritten with the same bytes: only the stamp changed
+                std::unique_lock<std::shared_mutex> lock(mutex);
+                if (entry->current && entry->current->hash == hash)
+                {
+                    entry->stamp = stamp;
+                    entry->failure = nullptr;
+                    touch(*entry);
+                    revalidations++;
+                    return entry->current;
+                }
+            }
+
+            // Blocks sized to the template, so small templates do not hold a whole default block
+            std::size_t source_size = source.size();
+            parse_options version_options = options;
+            version_options.arena = node_arena::create(std::min<std::size_t>(std::max<std::size_t>(source_size, 4096), 64 * 1024));
+            std::vector<std::shared_ptr<element>> nodes;
+            try
+            {
+                nodes = parse_html_string(source, version_options);
+            }
+            catch (...)
+            {
+                // Remember the broken version, so it is not read and parsed again until the file changes
+                std::shared_ptr<const cached_template> previous;
+                {
+                    std::unique_lock<std::shared_mutex> lock(mutex);
+                    entry->failure = std::current_exception();
+                    entry->failed_stamp = stamp;
+                    previous = entry->current;
+                    if (previous)
+                        touch(*entry);
+                }
+                failures++;
+                if (previous)
+                    return previous;
+                throw;
+            }
+            compiled_template compiled(nodes);
+            std::size_t memory = source_size + version_options.arena->capacity() +
+                                 compiled.rendered_size(std::map<std::string, std::string>());
+            auto version = std::make_shared<const cached_template>(cached_template{std::move(nodes), std::move(compiled), hash, memory});
+            parses++;
+
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            // The slot may have been erased or evicted meanwhile; the caller still gets the version
+            auto it = slots.find(path);
+            bool listed = it != slots.end() && it->second == entry;
+            if (listed)
+            {
+                if (entry->current)
+                    bytes -= entry->current->memory;
+                bytes += memory;
+            }
+            entry->current = version;
+            entry->stamp = stamp;
+            entry->failure = nullptr;
+            touch(*entry);
+            if (listed)
+                evict_over_limit(entry.get());
+            return version;
+        }
+        catch (...)
+        {
+            // Do not keep an empty slot for a file that failed its first load, unless it remembers a broken version
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            auto it = slots.find(path);
+            if (it != slots.end() && it->second == entry && !entry->current && !entry->failure)
+                slots.erase(it);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Evict least recently used templates until the total fits the limit.
+     * @param keep Slot that must stay (the one just loaded)
+     *
+     * Called with the cache-wide lock held exclusively. A linear scan finds
+     * the oldest template; caches hold tens or hundreds of templates, and
+     * this runs only when a template is parsed.
+     */
+    void template_cache::evict_over_limit(const slot *keep)
+    {
+        while (max_bytes != 0 && bytes > max_bytes)
+        {
+            auto victim = slots.end();
+            for (auto it = slots.begin(); it != slots.end(); ++it)
+            {
+                const slot &candidate = *it->second;
+                if (&candidate == keep || !candidate.current)
+                    continue;
+                if (victim == slots.end() || candidate.last_used < victim->second->last_used)
+                    victim = it;
+            }
+            if (victim == slots.end())
+                return;
+            bytes -= victim->second->current->memory;
+            slots.erase(victim);
+            evictions++;
+        }
+    }
+
+    bool template_cache::erase(const std::string &path)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = slots.find(path);
+        if (it == slots.end())
+            return false;
+        bool cached = it->second->current != nullptr;
+        if (cached)
+            bytes -= it->second->current->memory;
+        slots.erase(it);
+        return cached;
+    }
+
+    void template_cache::clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        slots.clear();
+        bytes = 0;
+    }
+
+    std::size_t template_cache::size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::size_t count = 0;
+        for (const auto &entry : slots)
+        {
+            if (entry.second->current)
+                count++;
+        }
+        return count;
+    }
+
+    std::size_t template_cache::memory_usage() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return bytes;
+    }
+
+    template_cache::statistics template_cache::get_statistics() const
+    {
+        statistics result;
+        result.hits = hits.load();
+        result.revalidations = revalidations.load();
+        result.parses = parses.load();
+        result.evictions = evictions.load();
+        result.failures = failures.load();
+        return result;
+    }
+}